@@ -4,9 +4,14 @@
 #include <edba/errors.hpp>
 #include <edba/detail/utils.hpp>
 
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/scope_exit.hpp>
+#include <boost/type_traits/is_floating_point.hpp>
+#include <boost/type_traits/is_integral.hpp>
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 #include <vector>
 #include <limits>
@@ -14,13 +19,22 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 
 #ifdef _WIN32
+#  include <winsock2.h>
 #  include <windows.h>
+#else
+#  include <poll.h>
 #endif
 
 #include <mysql.h>
 
+// Non-blocking C API appeared in MySQL 8.0.16, MariaDB has its own incompatible flavour
+#if MYSQL_VERSION_ID >= 80016 && !defined(MARIADB_BASE_VERSION)
+#  define EDBA_MYSQL_NONBLOCKING_API
+#endif
+
 namespace edba { namespace backend { namespace mysql { namespace {
 
 std::string g_backend_and_engine = "mysql";
@@ -31,38 +45,121 @@ public:
     edba_myerror(std::string const &str) : edba_error("edba::mysql::" + str) {}
 };
 
+/// Return true if text value of date or datetime column is zero date like 0000-00-00 or 2020-01-00, server accepts
+/// them in non strict mode but they don`t denote a point in time
+bool is_zero_date(const char* s, size_t len)
+{
+    return len >= 10 && s[4] == '-' && s[7] == '-'
+        && ((s[5] == '0' && s[6] == '0') || (s[8] == '0' && s[9] == '0'));
+}
+
+#ifdef EDBA_MYSQL_NONBLOCKING_API
+/// Wait until connection socket becomes readable, or also writable when \a output is set. Zero \a timeout_ms means
+/// don`t wait, negative means wait infinitely, otherwise wait until \a deadline. Return false if timeout has expired.
+bool wait_for_socket(MYSQL* conn, bool output, int timeout_ms, const boost::posix_time::ptime& deadline)
+{
+    using namespace boost::posix_time;
+
+    if(timeout_ms == 0)
+        return false;
+
+    int wait_ms = -1;
+    if(timeout_ms > 0)
+    {
+        time_duration left = deadline - microsec_clock::universal_time();
+        if(left.is_negative())
+            return false;
+
+        wait_ms = static_cast<int>(left.total_milliseconds());
+    }
+
+    pollfd pfd;
+    pfd.fd = conn->net.fd;
+    pfd.events = POLLIN | (output ? POLLOUT : 0);
+    pfd.revents = 0;
+
+#ifdef _WIN32
+    int rc = WSAPoll(&pfd, 1, wait_ms);
+    if(rc < 0)
+        throw edba_myerror("WSAPoll() failed while waiting for server");
+#else
+    int rc = poll(&pfd, 1, wait_ms);
+    if(rc < 0 && errno != EINTR)
+        throw edba_myerror("poll() failed while waiting for server");
+#endif
+
+    return rc != 0;
+}
+#endif
+
 namespace unprep {
 
 class result : public backend::result, public boost::static_visitor<bool>
 {
 public:
-    result(MYSQL *conn) :
-        res_(0)
+    // With \a use_result rows are read from connection one by one as they are fetched, connection can`t be used
+    // for other queries until all rows are read. Row is used in place until the next fetch, has_next() reads one
+    // row ahead and then current row is copied
+    result(MYSQL *conn, bool use_result) :
+        conn_(conn)
+      , res_(0)
+      , use_result_(use_result)
       , cols_(0)
       , current_row_(0)
       , row_(0)
+      , lengths_(0)
+      , next_row_(0)
+      , peeked_(false)
     {
-        res_ = mysql_store_result(conn);
+        res_ = use_result_ ? mysql_use_result(conn) : mysql_store_result(conn);
         if(!res_) {
             cols_ = mysql_field_count(conn);
             if(cols_ == 0)
                 throw edba_myerror("Seems that the query does not produce any result");
         }
-        else {
+        else
             cols_ = mysql_num_fields(res_);
-        }
 
+    }
+    result(MYSQL* conn, MYSQL_RES* res) :
+        conn_(conn)
+      , res_(res)
+      , use_result_(false)
+      , cols_(mysql_num_fields(res))
+      , current_row_(0)
+      , row_(0)
+      , lengths_(0)
+      , next_row_(0)
+      , peeked_(false)
+    {
     }
     ~result()
     {
         if(res_)
+        {
+            // Unread rows of unbuffered result must be consumed to keep connection usable
+            if(use_result_)
+                while(mysql_fetch_row(res_))
+                    ;
+
             mysql_free_result(res_);
+        }
     }
 
     virtual next_row has_next()
     {
         if(!res_)
             return last_row_reached;
+        if(use_result_) {
+            // Fetch would overwrite current row, so it is copied before reading ahead
+            if(!peeked_) {
+                if(row_)
+                    keep_row();
+                next_row_ = fetch_row();
+                peeked_ = true;
+            }
+            return next_row_ ? next_row_exists : last_row_reached;
+        }
         if(current_row_ >= mysql_num_rows(res_))
             return last_row_reached;
         else
@@ -74,9 +171,24 @@ public:
         if(!res_)
             return false;
         current_row_ ++;
-        row_ = mysql_fetch_row(res_);
+        if(!use_result_) {
+            row_ = mysql_fetch_row(res_);
+            return row_ != 0;
+        }
+
+        if(peeked_) {
+            row_ = next_row_;
+            peeked_ = false;
+        }
+        else
+            row_ = fetch_row();
+
+        lengths_ = 0;
         if(!row_)
             return false;
+        lengths_ = mysql_fetch_lengths(res_);
+        if(lengths_==0)
+            throw edba_myerror("Can't get length of column");
         return true;
     }
 
@@ -107,6 +219,36 @@ public:
         return true;
     }
 
+    bool operator()(string_ref* v)
+    {
+        size_t len;
+        char const *s = at(fetch_col_, len);
+        if(!s)
+            return false;
+        *v = string_ref(s, len);
+        return true;
+    }
+
+    bool operator()(std::vector<unsigned char>* v)
+    {
+        size_t len;
+        char const *s = at(fetch_col_, len);
+        if(!s)
+            return false;
+        v->assign(s, s + len);
+        return true;
+    }
+
+    bool operator()(blob_ref* v)
+    {
+        size_t len;
+        char const *s = at(fetch_col_, len);
+        if(!s)
+            return false;
+        *v = blob_ref(s, len);
+        return true;
+    }
+
     bool operator()(std::ostream* v)
     {
         size_t len;
@@ -123,10 +265,24 @@ public:
         char const *s = at(fetch_col_, len);
         if(!s)
             return false;
+        if(is_zero_date(s, len))
+            throw bad_value_cast();
         std::string tmp(s, len);
         *v = parse_time(tmp);
         return true;
     }
+
+    bool operator()(timestamp* v)
+    {
+        size_t len;
+        char const *s = at(fetch_col_, len);
+        if(!s)
+            return false;
+        if(is_zero_date(s, len))
+            throw bad_value_cast();
+        *v = parse_timestamp(string_ref(s, s + len));
+        return true;
+    }
     
     virtual bool is_null(int col)
     {
@@ -140,6 +296,8 @@ public:
 
     virtual boost::uint64_t rows()
     {
+        if(use_result_)
+            return boost::uint64_t(-1);
         return boost::uint64_t(mysql_num_rows(res_));
     }
 
@@ -186,6 +344,10 @@ private:
             throw empty_row_access();
         if(col < 0 || col >= cols_)
             throw invalid_column(col);
+        if(use_result_) {
+            len = lengths_[col];
+            return row_[col];
+        }
         unsigned long *lengths = mysql_fetch_lengths(res_);
         if(lengths==0)
             throw edba_myerror("Can't get length of column");
@@ -193,21 +355,64 @@ private:
         return row_[col];
     }
 
+    MYSQL_ROW fetch_row()
+    {
+        MYSQL_ROW r = mysql_fetch_row(res_);
+        if(!r && mysql_errno(conn_))
+            throw edba_myerror(mysql_error(conn_));
+        return r;
+    }
+
+    // Row returned by mysql_use_result is overwritten by the next fetch, so it is copied before reading ahead.
+    // Buffers keep their capacity, copying doesn`t allocate once the widest row was seen
+    void keep_row()
+    {
+        row_data_.clear();
+        for(int i=0;i<cols_;i++) {
+            if(row_[i])
+                row_data_.insert(row_data_.end(), row_[i], row_[i] + lengths_[i]);
+            row_data_.push_back('\0');
+        }
+
+        row_lengths_.assign(lengths_, lengths_ + cols_);
+        row_values_.resize(cols_);
+        size_t offset = 0;
+        for(int i=0;i<cols_;i++) {
+            row_values_[i] = row_[i] ? &row_data_[offset] : 0;
+            offset += (row_[i] ? row_lengths_[i] : 0) + 1;
+        }
+        row_ = &row_values_[0];
+        lengths_ = &row_lengths_[0];
+    }
+
+    MYSQL *conn_;
     MYSQL_RES *res_;
+    bool use_result_;
     int cols_;
     unsigned current_row_;
     int fetch_col_;
     MYSQL_ROW row_;
+    unsigned long *lengths_;                                //!< Lengths of current row values in use_result mode
+    MYSQL_ROW next_row_;                                    //!< Row read ahead by has_next() in use_result mode
+    bool peeked_;
+    std::vector<char> row_data_;                            //!< Copy of current row values kept while reading ahead
+    std::vector<char*> row_values_;
+    std::vector<unsigned long> row_lengths_;
 };
 
 class statement : public backend::statement, public boost::static_visitor<>
 {
 public:
-    statement(const string_ref& q, MYSQL *conn, session_stat* stat)
+    statement(const string_ref& q, MYSQL *conn, session_stat* stat, bool use_result)
       : backend::statement(stat)
       , bind_by_name_helper_(q, detail::question_marker())
       , conn_(conn)
       , params_no_(0)
+      , use_result_(use_result)
+#ifdef EDBA_MYSQL_NONBLOCKING_API
+      , async_stage_(async_done)
+      , async_res_(0)
+#endif
     {
         fmt_.imbue(std::locale::classic());
         bool inside_text = false;
@@ -281,12 +486,39 @@ public:
         s += '\'';
     }
 
+    void operator()(const timestamp& v)
+    {
+        std::string& s = at(bind_col_);
+        s.clear();
+        s.reserve(30);
+        s += '\'';
+        s += format_timestamp(v);
+        s += '\'';
+    }
+
+    // Hexadecimal literal passes binary data regardless of connection character set
+    void operator()(const blob_ref& v)
+    {
+        static const char digits[] = "0123456789ABCDEF";
+
+        std::string& s = at(bind_col_);
+        s.clear();
+        s.reserve(v.size() * 2 + 3);
+        s += "X'";
+        for(blob_ref::const_iterator it = v.begin(); it != v.end(); ++it)
+        {
+            s += digits[*it >> 4];
+            s += digits[*it & 0xF];
+        }
+        s += '\'';
+    }
+
     void operator()(std::istream* v)
     {
         std::ostringstream ss;
         ss << v->rdbuf();
         std::string tmp = ss.str();
-        bind(bind_col_, tmp);
+        (*this)(blob_ref(tmp.data(), tmp.size()));
     }
 
     void operator()(null_type)
@@ -314,7 +546,7 @@ public:
         if(mysql_real_query(conn_,real_query.c_str(),real_query.size())) {
             throw edba_myerror(mysql_error(conn_));
         }
-        return new result(conn_);
+        return new result(conn_, use_result_);
     }
 
     virtual void exec_impl()
@@ -333,6 +565,103 @@ public:
         }
     }
 
+#ifdef EDBA_MYSQL_NONBLOCKING_API
+    ~statement()
+    {
+        if(async_res_)
+            mysql_free_result(async_res_);
+    }
+
+    virtual void async_start_impl(bool)
+    {
+        bind_all(async_query_);
+        reset_params();
+
+        if(async_res_)
+        {
+            mysql_free_result(async_res_);
+            async_res_ = 0;
+        }
+
+        async_error_.clear();
+        async_stage_ = async_sending_query;
+    }
+
+    // Query may be not sent completely on the first call if it doesn`t fit into socket buffer. Server doesn`t
+    // answer until it has read the whole query, so while sending wait for socket to become writable as well
+    virtual bool async_wait_impl(int timeout_ms)
+    {
+        using namespace boost::posix_time;
+
+        ptime deadline = microsec_clock::universal_time() + milliseconds(timeout_ms);
+
+        while(async_stage_ != async_done)
+        {
+            net_async_status status;
+            if(async_stage_ == async_sending_query)
+            {
+                status = mysql_real_query_nonblocking(conn_, async_query_.c_str(), async_query_.size());
+                if(status == NET_ASYNC_COMPLETE)
+                    async_stage_ = async_storing_result;
+            }
+            else
+            {
+                status = mysql_store_result_nonblocking(conn_, &async_res_);
+                if(status == NET_ASYNC_COMPLETE)
+                {
+                    if(!async_res_ && mysql_field_count(conn_) != 0)
+                        async_error_ = mysql_error(conn_);
+                    async_stage_ = async_done;
+                }
+            }
+
+            if(status == NET_ASYNC_ERROR)
+            {
+                async_error_ = mysql_error(conn_);
+                async_stage_ = async_done;
+            }
+            else if(status == NET_ASYNC_NOT_READY
+                && !wait_for_socket(conn_, async_stage_ == async_sending_query, timeout_ms, deadline))
+                break;
+        }
+
+        return async_stage_ == async_done;
+    }
+
+    // Sending stage also reads reply of server, but C API doesn`t tell which direction it waits for. Waiting for
+    // writability is safe, at worst progress is polled until reply arrives
+    virtual bool async_wants_write_impl()
+    {
+        return async_stage_ == async_sending_query;
+    }
+
+    virtual backend::result_ptr async_query_result_impl()
+    {
+        if(!async_error_.empty())
+            throw edba_myerror(async_error_);
+
+        if(!async_res_)
+            throw edba_myerror("Seems that the query does not produce any result");
+
+        backend::result_ptr r(new result(conn_, async_res_));
+        async_res_ = 0;
+        return r;
+    }
+
+    virtual void async_exec_result_impl()
+    {
+        if(!async_error_.empty())
+            throw edba_myerror(async_error_);
+
+        if(async_res_)
+        {
+            mysql_free_result(async_res_);
+            async_res_ = 0;
+            throw edba_myerror("Calling exec() on query!");
+        }
+    }
+#endif
+
 private:
     std::string &at(int col)
     {
@@ -377,43 +706,92 @@ private:
     MYSQL *conn_;
     int params_no_;
     int bind_col_;
+    bool use_result_;
+
+#ifdef EDBA_MYSQL_NONBLOCKING_API
+    enum {
+        async_sending_query,
+        async_storing_result,
+        async_done
+    } async_stage_;
+
+    std::string async_query_;
+    std::string async_error_;
+    MYSQL_RES* async_res_;
+#endif
 };
 
 } // namespace uprep
 
 namespace prep {
 
+// Convert integer value, throw bad_value_cast if it doesn`t fit into \a T
+template<typename T, typename S>
+T integer_cast(S v)
+{
+    T r = static_cast<T>(v);
+    bool r_negative = !(r > T(0)) && r != T(0);
+    bool v_negative = !(v > S(0)) && v != S(0);
+    if(static_cast<S>(r) != v || r_negative != v_negative)
+        throw bad_value_cast();
+    return r;
+}
+
 class result : public backend::result, public boost::static_visitor<bool>
 {
-    struct bind_data
+    // Column is bound with buffer of its native type, text and binary data with buffer of maximal length
+    // when it is known
+    struct column
     {
-        bind_data() : ptr(0), length(0), is_null(0), error(0)
+        column() : type(MYSQL_TYPE_STRING), is_unsigned(false), decimals(0), integer(0), real(0), real_float(0), length(0), is_null(0), error(0)
         {
-            memset(&buf,0,sizeof(buf));
+            memset(&time,0,sizeof(time));
         }
 
-        char buf[128];
-        std::vector<char> vbuf;
-        char *ptr;
+        enum_field_types type;
+        bool is_unsigned;
+        unsigned decimals;                                  //!< Digits of second fraction for time columns
+        long long integer;
+        double real;
+        float real_float;
+        MYSQL_TIME time;
+        std::vector<char> buf;
+        std::string text;                                   //!< Value of non text column converted to text on request
         unsigned long length;
         my_bool is_null;
         my_bool error;
     };
 
 public:
-    result(MYSQL_STMT *stmt) 
+    // When statement has read only cursor rows are streamed from server in batches of STMT_ATTR_PREFETCH_ROWS,
+    // otherwise the whole result is stored on client side before the first row is fetched
+    result(MYSQL_STMT *stmt, bool cursor)
       : stmt_(stmt)
+      , cursor_(cursor)
       , current_row_(0)
       , meta_(0)
+      , rebind_(false)
+      , peeked_(false)
+      , peeked_row_(false)
     {
+        fmt_.imbue(std::locale::classic());
+
         cols_ = mysql_stmt_field_count(stmt_);
-        if(mysql_stmt_store_result(stmt_)) {
+        if(!cursor_ && mysql_stmt_store_result(stmt_)) {
             throw edba_myerror(mysql_stmt_error(stmt_));
         }
         meta_ = mysql_stmt_result_metadata(stmt_);
         if(!meta_) {
             throw edba_myerror("Seems that the query does not produce any result");
         }
+
+        try {
+            bind_columns();
+        }
+        catch(...) {
+            mysql_free_result(meta_);
+            throw;
+        }
     }
     ~result()
     {
@@ -426,6 +804,17 @@ public:
     ///
     virtual next_row has_next()
     {
+        if(cursor_) {
+            // Cursor can`t tell whether more rows exist without fetching, so the next row is read ahead into
+            // bound buffers while copy of the current row is kept for access. Costs copy of one row per call
+            if(!peeked_) {
+                peeked_columns_ = columns_;
+                peeked_row_ = fetch_row();
+                peeked_ = true;
+                columns_.swap(peeked_columns_);
+            }
+            return peeked_row_ ? next_row_exists : last_row_reached;
+        }
         if(current_row_ >= mysql_stmt_num_rows(stmt_))
             return last_row_reached;
         else
@@ -438,31 +827,15 @@ public:
     virtual bool next()
     {
         current_row_ ++;
-        reset();
-        if(cols_ > 0) {
-            if(mysql_stmt_bind_result(stmt_,&bind_[0])) {
-                throw edba_myerror(mysql_stmt_error(stmt_));
-            }
-        }
-        int r = mysql_stmt_fetch(stmt_);
-        if(r==MYSQL_NO_DATA) {
-            return false;
-        }
-        if(r==MYSQL_DATA_TRUNCATED) {
-            for(int i=0;i<cols_;i++) {
-                if(bind_data_[i].error && !bind_data_[i].is_null && bind_data_[i].length >= sizeof(bind_data_[i].buf)) {
-                    bind_data_[i].vbuf.resize(bind_data_[i].length);
-                    MYSQL_BIND b=MYSQL_BIND();
-                    bind_[i].buffer = &bind_data_[i].vbuf.front();
-                    bind_[i].buffer_length = bind_data_[i].length;
-                    if(mysql_stmt_fetch_column(stmt_,&bind_[i],i,0)) {
-                        throw edba_myerror(mysql_stmt_error(stmt_));
-                    }
-                    bind_data_[i].ptr = &bind_data_[i].vbuf.front();
-                }
-            }
+
+        // Row read ahead by has_next() is in bound buffers, swapping vectors keeps addresses of their elements
+        if(peeked_) {
+            columns_.swap(peeked_columns_);
+            peeked_ = false;
+            return peeked_row_;
         }
-        return true;
+
+        return fetch_row();
     }
 
     virtual bool fetch(int col, const fetch_types_variant& v)
@@ -472,41 +845,110 @@ public:
     }
 
     template<typename T>
-    bool operator()(T* v, typename boost::enable_if< boost::is_arithmetic<T> >::type* = 0)
+    bool operator()(T* v, typename boost::enable_if< boost::is_integral<T> >::type* = 0)
     {
-        bind_data& d = at(fetch_col_);
-        if(d.is_null)
+        column& c = at(fetch_col_);
+        if(c.is_null)
             return false;
 
-        parse_number(string_ref(d.ptr,d.length), *v);
+        if(c.type == MYSQL_TYPE_LONGLONG) {
+            if(c.is_unsigned)
+                *v = integer_cast<T>(static_cast<unsigned long long>(c.integer));
+            else
+                *v = integer_cast<T>(c.integer);
+        }
+        else
+            parse_number(text(c), *v);
+
+        return true;
+    }
+
+    template<typename T>
+    bool operator()(T* v, typename boost::enable_if< boost::is_floating_point<T> >::type* = 0)
+    {
+        column& c = at(fetch_col_);
+        if(c.is_null)
+            return false;
+
+        if(c.type == MYSQL_TYPE_LONGLONG)
+            *v = c.is_unsigned ? static_cast<T>(static_cast<unsigned long long>(c.integer)) : static_cast<T>(c.integer);
+        else if(c.type == MYSQL_TYPE_FLOAT)
+            *v = static_cast<T>(c.real_float);
+        else if(c.type == MYSQL_TYPE_DOUBLE) {
+            if(c.real > (std::numeric_limits<T>::max)() || c.real < -(std::numeric_limits<T>::max)())
+                throw bad_value_cast();
+            *v = static_cast<T>(c.real);
+        }
+        else
+            parse_number(text(c), *v);
 
         return true;
     }
 
     bool operator()(std::string* v)
     {
-        bind_data &d = at(fetch_col_);
-        if(d.is_null)
+        column& c = at(fetch_col_);
+        if(c.is_null)
+            return false;
+        string_ref t = text(c);
+        v->assign(t.begin(), t.end());
+        return true;
+    }
+
+    bool operator()(string_ref* v)
+    {
+        column& c = at(fetch_col_);
+        if(c.is_null)
+            return false;
+        *v = text(c);
+        return true;
+    }
+
+    bool operator()(std::vector<unsigned char>* v)
+    {
+        column& c = at(fetch_col_);
+        if(c.is_null)
             return false;
-        v->assign(d.ptr,d.length);
+        string_ref t = text(c);
+        v->assign(t.begin(), t.end());
+        return true;
+    }
+
+    bool operator()(blob_ref* v)
+    {
+        column& c = at(fetch_col_);
+        if(c.is_null)
+            return false;
+        string_ref t = text(c);
+        *v = blob_ref(t.begin(), t.size());
         return true;
     }
 
     bool operator()(std::ostream* v)
     {
-        bind_data &d = at(fetch_col_);
-        if(d.is_null)
+        column& c = at(fetch_col_);
+        if(c.is_null)
             return false;
-        v->write(d.ptr,d.length);
+        string_ref t = text(c);
+        v->write(t.begin(), t.size());
         return true;
     }
 
     bool operator()(std::tm* v)
     {
-        std::string tmp;
-        if(!this->operator()(&tmp))
+        column& c = at(fetch_col_);
+        if(c.is_null)
             return false;
-        *v = parse_time(tmp);
+        *v = c.type == MYSQL_TYPE_DATETIME ? to_timestamp(c.time).to_tm() : parse_time(to_string(text(c)));
+        return true;
+    }
+
+    bool operator()(timestamp* v)
+    {
+        column& c = at(fetch_col_);
+        if(c.is_null)
+            return false;
+        *v = c.type == MYSQL_TYPE_DATETIME ? to_timestamp(c.time) : parse_timestamp(text(c));
         return true;
     }
 
@@ -526,7 +968,9 @@ public:
     }
     virtual boost::uint64_t rows()
     {
-        return boost::uint64_t(mysql_num_rows(meta_));
+        if(cursor_)
+            return boost::uint64_t(-1);
+        return boost::uint64_t(mysql_stmt_num_rows(stmt_));
     }
     virtual std::string column_to_name(int col)
     {
@@ -551,100 +995,311 @@ public:
     }
 
 private:
-    void reset()
+    // Initial buffer size for text column when its maximal length is unknown, longer values are refetched
+    static const unsigned long default_text_buffer = 256;
+
+    void bind_columns()
     {
-        bind_.resize(0);
-        bind_data_.resize(0);
+        if(cols_ == 0)
+            return;
+
+        MYSQL_FIELD *flds=mysql_fetch_fields(meta_);
+        if(!flds) {
+            throw edba_myerror("Internal error empty fileds");
+        }
+
+        columns_.resize(cols_);
         bind_.resize(cols_,MYSQL_BIND());
-        bind_data_.resize(cols_,bind_data());
+
         for(int i=0;i<cols_;i++) {
-            bind_[i].buffer_type = MYSQL_TYPE_STRING;
-            bind_[i].buffer = bind_data_[i].buf;
-            bind_[i].buffer_length = sizeof(bind_data_[i].buf);
-            bind_[i].length = &bind_data_[i].length;
-            bind_[i].is_null = &bind_data_[i].is_null;
-            bind_[i].error = &bind_data_[i].error;
-            bind_data_[i].ptr = bind_data_[i].buf;
+            column& c = columns_[i];
+            MYSQL_BIND& b = bind_[i];
+
+            b.length = &c.length;
+            b.is_null = &c.is_null;
+            b.error = &c.error;
+
+            switch(flds[i].type) {
+            case MYSQL_TYPE_TINY:
+            case MYSQL_TYPE_SHORT:
+            case MYSQL_TYPE_INT24:
+            case MYSQL_TYPE_LONG:
+            case MYSQL_TYPE_LONGLONG:
+            case MYSQL_TYPE_YEAR:
+                c.type = MYSQL_TYPE_LONGLONG;
+                c.is_unsigned = (flds[i].flags & UNSIGNED_FLAG) != 0;
+                b.buffer = &c.integer;
+                b.is_unsigned = c.is_unsigned;
+                break;
+            case MYSQL_TYPE_FLOAT:
+                c.type = MYSQL_TYPE_FLOAT;
+                b.buffer = &c.real_float;
+                break;
+            case MYSQL_TYPE_DOUBLE:
+                c.type = MYSQL_TYPE_DOUBLE;
+                b.buffer = &c.real;
+                break;
+            case MYSQL_TYPE_DATE:
+            case MYSQL_TYPE_DATETIME:
+            case MYSQL_TYPE_TIMESTAMP:
+                c.type = MYSQL_TYPE_DATETIME;
+                c.decimals = (std::min)(flds[i].decimals, 6u);
+                b.buffer = &c.time;
+                break;
+            default:
+                {
+                    // Decimals, time intervals, bits and text are fetched as text. Maximal length is known
+                    // for stored result, see STMT_ATTR_UPDATE_MAX_LENGTH
+                    unsigned long size = cursor_ ? (std::min)(flds[i].length, (unsigned long)(default_text_buffer)) : flds[i].max_length;
+                    c.type = MYSQL_TYPE_STRING;
+                    c.buf.resize((std::max)(size, 1ul));
+                    b.buffer = &c.buf.front();
+                    b.buffer_length = c.buf.size();
+                }
+                break;
+            }
+
+            b.buffer_type = c.type;
+        }
+
+        if(mysql_stmt_bind_result(stmt_,&bind_[0])) {
+            throw edba_myerror(mysql_stmt_error(stmt_));
         }
     }
 
-    bind_data &at(int col)
+    // Fetch next row into bound buffers, return false if there are no more rows
+    bool fetch_row()
+    {
+        // Buffers grown for truncated values of previous row should be bound again
+        if(rebind_) {
+            if(mysql_stmt_bind_result(stmt_,&bind_[0])) {
+                throw edba_myerror(mysql_stmt_error(stmt_));
+            }
+            rebind_ = false;
+        }
+
+        int r = mysql_stmt_fetch(stmt_);
+        if(r==MYSQL_NO_DATA) {
+            return false;
+        }
+        if(r==1) {
+            throw edba_myerror(mysql_stmt_error(stmt_));
+        }
+        if(r==MYSQL_DATA_TRUNCATED) {
+            for(int i=0;i<cols_;i++) {
+                column& c = columns_[i];
+                if(c.error && !c.is_null && c.length > c.buf.size()) {
+                    c.buf.resize(c.length);
+                    bind_[i].buffer = &c.buf.front();
+                    bind_[i].buffer_length = c.length;
+                    if(mysql_stmt_fetch_column(stmt_,&bind_[i],i,0)) {
+                        throw edba_myerror(mysql_stmt_error(stmt_));
+                    }
+                    rebind_ = true;
+                }
+            }
+        }
+        return true;
+    }
+
+    static timestamp to_timestamp(const MYSQL_TIME& t)
+    {
+        // Zero dates like 0000-00-00 or 2020-01-00 accepted by server don`t denote a point in time
+        if(t.month == 0 || t.day == 0)
+            throw bad_value_cast();
+
+        std::tm tm = std::tm();
+        tm.tm_year = int(t.year) - 1900;
+        tm.tm_mon = int(t.month) - 1;
+        tm.tm_mday = int(t.day);
+        tm.tm_hour = int(t.hour);
+        tm.tm_min = int(t.minute);
+        tm.tm_sec = int(t.second);
+        return timestamp::from_tm(tm, int(t.second_part));
+    }
+
+    // Return value as text, the same as server would send it for unprepared query
+    string_ref text(column& c)
+    {
+        switch(c.type) {
+        case MYSQL_TYPE_STRING:
+            return string_ref(&c.buf.front(), c.length);
+        case MYSQL_TYPE_DATETIME:
+            {
+                // Formatted from fields, so zero dates are returned as is. Server sends as many digits of
+                // second fraction as column declares
+                const MYSQL_TIME& t = c.time;
+                fmt_.str(std::string());
+                fmt_ << std::setfill('0') << std::setw(4) << t.year << '-' << std::setw(2) << t.month << '-' << std::setw(2) << t.day;
+                if(t.time_type != MYSQL_TIMESTAMP_DATE) {
+                    fmt_ << ' ' << std::setw(2) << t.hour << ':' << std::setw(2) << t.minute << ':' << std::setw(2) << t.second;
+                    if(c.decimals != 0)
+                        fmt_ << '.' << std::setw(6) << t.second_part;
+                }
+                fmt_ << std::setfill(' ');
+
+                c.text = fmt_.str();
+                if(t.time_type != MYSQL_TIMESTAMP_DATE && c.decimals != 0)
+                    c.text.resize(20 + c.decimals);
+            }
+            return c.text;
+        default:
+            break;
+        }
+
+        fmt_.str(std::string());
+        if(c.type == MYSQL_TYPE_LONGLONG) {
+            if(c.is_unsigned)
+                fmt_ << static_cast<unsigned long long>(c.integer);
+            else
+                fmt_ << c.integer;
+        }
+        else if(c.type == MYSQL_TYPE_FLOAT)
+            fmt_ << std::setprecision(std::numeric_limits<float>::digits10+1) << c.real_float;
+        else
+            fmt_ << std::setprecision(std::numeric_limits<double>::digits10+1) << c.real;
+
+        c.text = fmt_.str();
+        return c.text;
+    }
+
+    column &at(int col)
     {
         if(col < 0 || col >= cols_)
             throw invalid_column(col);
-        if(bind_data_.empty())
+        if(current_row_ == 0)
             throw edba_myerror("Attempt to access data without fetching it first");
-        return bind_data_.at(col);
+        return columns_[col];
     }
 
     int cols_;
     MYSQL_STMT *stmt_;
+    bool cursor_;
     unsigned current_row_;
     MYSQL_RES *meta_;
     std::vector<MYSQL_BIND> bind_;
-    std::vector<bind_data> bind_data_;
+    std::vector<column> columns_;
+    bool rebind_;                                           //!< Buffers have grown and should be bound again before next fetch
+    bool peeked_;                                           //!< Next row was read ahead by has_next() in cursor mode
+    bool peeked_row_;                                       //!< Result of read ahead
+    std::vector<column> peeked_columns_;                    //!< Bound buffers while they hold row read ahead
     int fetch_col_;
+    std::ostringstream fmt_;
 };
 
 class statement : public backend::statement, public boost::static_visitor<>
 {
+    // Parameters live in arena allocated once per statement. Numbers and times are bound from native buffers,
+    // text keeps its capacity between executions
     struct param
     {
         my_bool is_null;
-        bool is_blob;
+        my_bool is_unsigned;
+        enum_field_types type;
         unsigned long length;
+        long long integer;
+        double real;
+        float real_float;
+        MYSQL_TIME time;
         std::string value;
-        void *buffer;
+        const void *buffer;
 
         param() :
             is_null(1)
-          , is_blob(false)
+          , is_unsigned(0)
+          , type(MYSQL_TYPE_NULL)
           , length(0)
+          , integer(0)
+          , real(0)
+          , real_float(0)
           , buffer(0)
         {
+            memset(&time, 0, sizeof(time));
+        }
+        void reset()
+        {
+            is_null = 1;
+            is_unsigned = 0;
+            type = MYSQL_TYPE_NULL;
+            length = 0;
+            buffer = 0;
+            value.clear();
         }
-        void set(char const *b,char const *e,bool blob=false)
+        void set(char const *b,char const *e,enum_field_types t)
         {
+            buffer = b;
             length = e - b;
-            buffer = const_cast<char *>(b);
-            is_blob = blob;
+            type = t;
+            is_null = 0;
+        }
+        void set_value(enum_field_types t)
+        {
+            set(value.data(), value.data() + value.size(), t);
+        }
+        void set_integer(long long v,bool u)
+        {
+            integer = v;
+            is_unsigned = u;
+            buffer = &integer;
+            length = sizeof(integer);
+            type = MYSQL_TYPE_LONGLONG;
             is_null = 0;
         }
-        void set_str(std::string const &s)
+        void set_real(double v)
         {
-            value = s;
-            buffer = const_cast<char *>(value.c_str());
-            length = value.size();
+            real = v;
+            buffer = &real;
+            length = sizeof(real);
+            type = MYSQL_TYPE_DOUBLE;
             is_null = 0;
         }
-        void set(std::tm const &t)
+        void set_float(float v)
         {
-            set_str(format_time(t));
+            real_float = v;
+            buffer = &real_float;
+            length = sizeof(real_float);
+            type = MYSQL_TYPE_FLOAT;
+            is_null = 0;
+        }
+        void set_time(std::tm const &t,unsigned long fraction)
+        {
+            memset(&time, 0, sizeof(time));
+            time.year = t.tm_year + 1900;
+            time.month = t.tm_mon + 1;
+            time.day = t.tm_mday;
+            time.hour = t.tm_hour;
+            time.minute = t.tm_min;
+            time.second = t.tm_sec;
+            time.second_part = fraction;
+            time.time_type = MYSQL_TIMESTAMP_DATETIME;
+
+            buffer = &time;
+            length = sizeof(time);
+            type = MYSQL_TYPE_DATETIME;
+            is_null = 0;
         }
         void bind_it(MYSQL_BIND *b)
         {
             b->is_null = &is_null;
+            b->buffer_type = type;
             if(!is_null) {
-                b->buffer_type = is_blob ? MYSQL_TYPE_BLOB : MYSQL_TYPE_STRING;
-                b->buffer = buffer;
+                b->buffer = const_cast<void *>(buffer);
                 b->buffer_length = length;
                 b->length = &length;
-            }
-            else {
-                b->buffer_type = MYSQL_TYPE_NULL;
+                b->is_unsigned = is_unsigned;
             }
         }
     };
 
 public:
-    statement(const string_ref& q, MYSQL *conn, session_stat* stat) 
+    // Non zero \a prefetch_rows opens read only cursor for every query and streams its rows
+    statement(const string_ref& q, MYSQL *conn, session_stat* stat, unsigned long prefetch_rows)
       : backend::statement(stat)
       , bind_by_name_helper_(q, detail::question_marker())
       , stmt_(0)
       , params_count_(0)
+      , cursor_(prefetch_rows != 0)
     {
-        fmt_.imbue(std::locale::classic());
-
         stmt_ = mysql_stmt_init(conn);
         try {
             if(!stmt_) {
@@ -657,6 +1312,23 @@ public:
                 throw edba_myerror(mysql_stmt_error(stmt_));
             }
             params_count_ = mysql_stmt_param_count(stmt_);
+
+            if(cursor_) {
+                unsigned long type = CURSOR_TYPE_READ_ONLY;
+                if(mysql_stmt_attr_set(stmt_, STMT_ATTR_CURSOR_TYPE, &type)
+                    || mysql_stmt_attr_set(stmt_, STMT_ATTR_PREFETCH_ROWS, &prefetch_rows)) {
+                    throw edba_myerror(mysql_stmt_error(stmt_));
+                }
+            }
+            else {
+                // Stored result reports maximal length of values, so text columns are bound with buffers
+                // that are never truncated
+                my_bool update_max_length = 1;
+                if(mysql_stmt_attr_set(stmt_, STMT_ATTR_UPDATE_MAX_LENGTH, &update_max_length)) {
+                    throw edba_myerror(mysql_stmt_error(stmt_));
+                }
+            }
+
             reset_data();
         }
         catch(...) {
@@ -690,36 +1362,66 @@ public:
     }
 
     template<typename T>
-    void operator()(T v, typename boost::enable_if< boost::is_arithmetic<T> >::type* = 0)
+    void operator()(T v, typename boost::enable_if< boost::is_integral<T> >::type* = 0)
     {
-        fmt_.str(std::string());
-        if(!std::numeric_limits<T>::is_integer)
-            fmt_ << std::setprecision(std::numeric_limits<T>::digits10+1);
-        fmt_ << v;
-        at(bind_col_).set_str(fmt_.str());
+        at(bind_col_).set_integer(static_cast<long long>(v), !std::numeric_limits<T>::is_signed);
+    }
+
+    // Float is sent as is, widening it to double would make server store binary noise of its representation in
+    // text and decimal columns. MySQL has no wider floating point type than DOUBLE, so long double is narrowed
+    void operator()(float v)
+    {
+        at(bind_col_).set_float(v);
+    }
+
+    void operator()(double v)
+    {
+        at(bind_col_).set_real(v);
+    }
+
+    void operator()(long double v)
+    {
+        at(bind_col_).set_real(static_cast<double>(v));
     }
 
     void operator()(const string_ref& rng)
     {
-        at(bind_col_).set(rng.begin(), rng.end());
+        at(bind_col_).set(rng.begin(), rng.end(), MYSQL_TYPE_STRING);
     }
 
     void operator()(const std::tm& v)
     {
-        at(bind_col_).set(v);
+        at(bind_col_).set_time(v, 0);
+    }
+
+    void operator()(const timestamp& v)
+    {
+        at(bind_col_).set_time(v.to_tm(), v.fraction());
+    }
+
+    void operator()(const blob_ref& v)
+    {
+        param& p = at(bind_col_);
+        p.value.assign(v.data(), v.size());
+        p.set_value(MYSQL_TYPE_BLOB);
+    }
+
+    void operator()(const borrowed_blob& v)
+    {
+        // Caller keeps data alive until execution, see by_ref
+        at(bind_col_).set(v.data(), v.data() + v.size(), MYSQL_TYPE_BLOB);
     }
 
     void operator()(std::istream* v)
     {
-        std::ostringstream ss;
-        ss << v->rdbuf();
-        at(bind_col_).set_str(ss.str());
-        at(bind_col_).is_blob = true;
+        param& p = at(bind_col_);
+        p.value.assign(std::istreambuf_iterator<char>(*v), std::istreambuf_iterator<char>());
+        p.set_value(MYSQL_TYPE_BLOB);
     }
 
     void operator()(null_type)
     {
-        at(bind_col_)=param();
+        at(bind_col_).reset();
     }
 
     // ----------- backend::statement -----------
@@ -756,7 +1458,7 @@ public:
         if(mysql_stmt_execute(stmt_)) {
             throw edba_myerror(mysql_stmt_error(stmt_));
         }
-        return backend::result_ptr(new result(stmt_));
+        return backend::result_ptr(new result(stmt_, cursor_));
     }
     ///
     /// Execute a statement, MAY throw edba_error if the statement returns results.
@@ -780,10 +1482,10 @@ public:
 private:
     void reset_data()
     {
-        params_.resize(0);
         params_.resize(params_count_);
-        bind_.resize(0);
-        bind_.resize(params_count_,MYSQL_BIND());
+        for(unsigned i=0;i<params_.size();i++)
+            params_[i].reset();
+        bind_.assign(params_count_,MYSQL_BIND());
     }
 
     param &at(int col)
@@ -804,7 +1506,6 @@ private:
         }
     }
 
-    std::ostringstream fmt_;
     std::vector<param> params_;
     std::vector<MYSQL_BIND> bind_;
 
@@ -812,6 +1513,7 @@ private:
     MYSQL_STMT *stmt_;
     int params_count_;
     int bind_col_;
+    bool cursor_;
 };
 
 } // namespace prep
@@ -822,7 +1524,20 @@ public:
     connection(conn_info const &ci, session_monitor* sm) :
         backend::connection(ci, sm)
       , conn_(0)
+      , prefetch_rows_(0)
     {
+        string_ref fetch_mode = ci.get("@fetch_mode", "store");
+        if(boost::algorithm::iequals(fetch_mode, "stream")) {
+            int prefetch_rows = ci.get("@prefetch_rows", 1024);
+            if(prefetch_rows <= 0) {
+                throw edba_myerror("@prefetch_rows property should be positive");
+            }
+            prefetch_rows_ = prefetch_rows;
+        }
+        else if(!boost::algorithm::iequals(fetch_mode, "store")) {
+            throw edba_myerror("@fetch_mode property should be either store or stream");
+        }
+
         conn_ = mysql_init(0);
         if(!conn_) {
               throw edba_error("edba::mysql failed to create connection");
@@ -1034,12 +1749,12 @@ public:
     
     virtual backend::statement_ptr prepare_statement_impl(const string_ref& q)
     {
-        return backend::statement_ptr(new prep::statement(q, conn_, &stat_));
+        return backend::statement_ptr(new prep::statement(q, conn_, &stat_, prefetch_rows_));
     }
 
     virtual backend::statement_ptr create_statement_impl(const string_ref& q)
     {
-        return backend::statement_ptr(new unprep::statement(q, conn_, &stat_));
+        return backend::statement_ptr(new unprep::statement(q, conn_, &stat_, prefetch_rows_ != 0));
     }
     
     virtual std::string escape(const string_ref& str)
@@ -1071,6 +1786,11 @@ public:
         return description_;
     }
 
+    virtual int native_socket()
+    {
+        return int(conn_->net.fd);
+    }
+
 private:
     void mysql_set_option(mysql_option option, const void* arg)
     {
@@ -1082,6 +1802,7 @@ private:
 
     MYSQL *conn_;
     std::string description_;
+    unsigned long prefetch_rows_;                           //!< Rows fetched at once by prepared statement cursor, 0 if results are stored
 };
 
 }}}} // edba, backend, mysql, anonymous
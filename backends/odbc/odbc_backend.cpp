@@ -14,6 +14,9 @@
 #include <boost/mpl/int.hpp>
 #include <boost/mpl/at.hpp>
 #include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/type_traits/is_floating_point.hpp>
+#include <boost/type_traits/is_signed.hpp>
+#include <boost/foreach.hpp>
 #include <boost/format.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/random_access_index.hpp>
@@ -145,6 +148,43 @@ typedef mpl::map<
   , mpl::pair< long double,         mpl::pair< mpl::int_<SQL_C_DOUBLE>,     double> >
   > type_ids_map;
 
+// SQL C types used for row array fetch. Stride of bound array is defined by SQL C type, so storage type
+// must have exactly its size, unlike type_ids_map where long is used for SQL_C_SLONG.
+template<size_t Size, bool Signed> struct array_integer_type;
+template<> struct array_integer_type<2, true>  { typedef SQLSMALLINT  type; static const SQLSMALLINT id = SQL_C_SSHORT; };
+template<> struct array_integer_type<2, false> { typedef SQLUSMALLINT type; static const SQLSMALLINT id = SQL_C_USHORT; };
+template<> struct array_integer_type<4, true>  { typedef SQLINTEGER   type; static const SQLSMALLINT id = SQL_C_SLONG; };
+template<> struct array_integer_type<4, false> { typedef SQLUINTEGER  type; static const SQLSMALLINT id = SQL_C_ULONG; };
+template<> struct array_integer_type<8, true>  { typedef SQLBIGINT    type; static const SQLSMALLINT id = SQL_C_SBIGINT; };
+template<> struct array_integer_type<8, false> { typedef SQLUBIGINT   type; static const SQLSMALLINT id = SQL_C_UBIGINT; };
+
+template<typename T, typename Enable = void>
+struct array_c_type : array_integer_type<sizeof(T), boost::is_signed<T>::value> {};
+
+template<typename T>
+struct array_c_type<T, typename boost::enable_if< boost::is_floating_point<T> >::type>
+{
+    typedef SQLDOUBLE type;
+    static const SQLSMALLINT id = SQL_C_DOUBLE;
+};
+
+// Storage bound to single column during row array fetch
+struct array_column
+{
+    vector<char> data_;
+    vector<SQLLEN> indicators_;
+};
+
+// Return true for column vectors that can be filled by row array fetch
+struct is_array_fetchable : boost::static_visitor<bool>
+{
+    template<typename T>
+    bool operator()(std::vector<T>*) const
+    {
+        return boost::is_arithmetic<T>::value;
+    }
+};
+
 struct error_checker
 {
     bool wide_;
@@ -308,6 +348,8 @@ public:
 
         max_column_size = (min)(max_column_size, MAX_READ_BUFFER_SIZE);
         column_char_buf_.resize(max_column_size);
+        ref_values_.resize(columns_.size());
+        blob_values_.resize(columns_.size());
     }
 
     ~result()
@@ -350,6 +392,16 @@ public:
     }
 
     bool operator()(tm* data)
+    {
+        timestamp tmp;
+        if (!(*this)(&tmp))
+            return false;
+
+        *data = tmp.to_tm();
+        return true;
+    }
+
+    bool operator()(timestamp* data)
     {
         TIMESTAMP_STRUCT tmp;
         SQLLEN indicator;
@@ -359,20 +411,11 @@ public:
         if (SQL_NULL_DATA == indicator)
             return false;
 
-        data->tm_isdst = -1;
-        data->tm_year = tmp.year - 1900;
-        data->tm_mon = tmp.month - 1;
-        data->tm_mday = tmp.day;
-        data->tm_hour = tmp.hour;
-        data->tm_min = tmp.minute;
-        data->tm_sec = tmp.second;
-
-        // normalize and compute the remaining fields
-#ifdef _WIN32
-        _mkgmtime(data);
-#else
-        mktime(data);
-#endif
+        // fraction is in nanoseconds
+        boost::int64_t days = days_from_civil(tmp.year, tmp.month, tmp.day);
+        boost::int64_t seconds = days * 86400 + tmp.hour * 3600 + tmp.minute * 60 + tmp.second;
+        *data = timestamp(seconds * 1000000 + tmp.fraction / 1000);
+
         return true;
     }
 
@@ -414,6 +457,17 @@ public:
         return true;
     }
 
+    bool operator()(string_ref* data)
+    {
+        // Driver doesn`t expose its buffers, keep converted value alive until next row
+        string& value = ref_values_[fetch_col_ - 1];
+        if (!(*this)(&value))
+            return false;
+
+        *data = string_ref(value);
+        return true;
+    }
+
     bool operator()(ostream* data)
     {
         SQLLEN indicator;
@@ -448,6 +502,86 @@ public:
         return true;
     }
 
+    bool operator()(std::vector<unsigned char>* data)
+    {
+        SQLLEN indicator;
+        SQLRETURN r;
+        std::vector<unsigned char> tmp;
+
+        do
+        {
+            r = throw_on_error_("SQLGetData") = SQLGetData(stmt_, fetch_col_, SQL_C_BINARY, &column_char_buf_[0], column_char_buf_.size(), &indicator);
+
+            if (SQL_NULL_DATA == indicator)
+                return false;
+
+            SQLLEN bytes_read = (SQL_NO_TOTAL == indicator) ? (SQLLEN)column_char_buf_.size() : (min)(indicator, (SQLLEN)column_char_buf_.size());
+            tmp.insert(tmp.end(), column_char_buf_.begin(), column_char_buf_.begin() + bytes_read);
+        } while(SQL_SUCCESS_WITH_INFO == r);
+
+        data->swap(tmp);
+        return true;
+    }
+
+    bool operator()(blob_ref* data)
+    {
+        std::vector<unsigned char>& value = blob_values_[fetch_col_ - 1];
+        if (!(*this)(&value))
+            return false;
+
+        *data = blob_ref(value);
+        return true;
+    }
+
+    virtual std::size_t fetch_batch(std::size_t n, std::vector<column_buffer>& buffers)
+    {
+        // Bound columns can`t be combined with SQLGetData when row array is fetched, so only batches
+        // that consist of numeric columns are fetched natively
+        is_array_fetchable fetchable;
+        BOOST_FOREACH(column_buffer& b, buffers)
+        {
+            if (b.column < 0 || (size_t)b.column >= columns_.size())
+                throw invalid_column(b.column);
+
+            if (!b.values.apply_visitor(fetchable))
+                return backend::result::fetch_batch(n, buffers);
+        }
+
+        BOOST_FOREACH(column_buffer& b, buffers)
+            b.reset(n);
+
+        vector<array_column> arrays(buffers.size());
+        SQLULEN fetched = 0;
+        SQLRETURN r;
+
+        {
+            row_array_guard guard(stmt_);
+
+            throw_on_error_("SQLSetStmtAttr") = SQLSetStmtAttr(stmt_, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)n, 0);
+            throw_on_error_("SQLSetStmtAttr") = SQLSetStmtAttr(stmt_, SQL_ATTR_ROWS_FETCHED_PTR, &fetched, 0);
+
+            for (size_t i = 0; i < buffers.size(); ++i)
+            {
+                bind_array binder(*this, arrays[i], buffers[i].column + 1, n);
+                buffers[i].values.apply_visitor(binder);
+            }
+
+            r = SQLFetch(stmt_);
+            if (SQL_NO_DATA == r)
+                fetched = 0;
+            else
+                throw_on_error_("SQLFetch") = r;
+        }
+
+        for (size_t i = 0; i < buffers.size(); ++i)
+        {
+            copy_array copier(arrays[i], buffers[i], fetched);
+            buffers[i].values.apply_visitor(copier);
+        }
+
+        return fetched;
+    }
+
     virtual next_row has_next()
     {
         // not supported by odbc
@@ -517,11 +651,99 @@ public:
     }
 
 private:
+    // Unbind columns and restore single row fetch after row array fetch
+    struct row_array_guard
+    {
+        row_array_guard(SQLHSTMT stmt) : stmt_(stmt) {}
+
+        ~row_array_guard()
+        {
+            SQLFreeStmt(stmt_, SQL_UNBIND);
+            SQLSetStmtAttr(stmt_, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)1, 0);
+            SQLSetStmtAttr(stmt_, SQL_ATTR_ROWS_FETCHED_PTR, 0, 0);
+        }
+
+        SQLHSTMT stmt_;
+    };
+
+    // Allocate storage for n values of numeric column and bind it
+    struct bind_array : boost::static_visitor<>
+    {
+        bind_array(result& res, array_column& arr, SQLUSMALLINT col, size_t n)
+          : res_(res), arr_(arr), col_(col), n_(n)
+        {}
+
+        template<typename T>
+        void operator()(std::vector<T>*, typename boost::enable_if< boost::is_arithmetic<T> >::type* = 0) const
+        {
+            typedef array_c_type<T> c_type;
+            typedef typename c_type::type storage_type;
+
+            arr_.data_.resize(n_ * sizeof(storage_type));
+            arr_.indicators_.resize(n_);
+
+            res_.throw_on_error_("SQLBindCol") = SQLBindCol(
+                res_.stmt_, col_, c_type::id, &arr_.data_[0], sizeof(storage_type), &arr_.indicators_[0]
+              );
+        }
+
+        template<typename T>
+        void operator()(std::vector<T>*, typename boost::disable_if< boost::is_arithmetic<T> >::type* = 0) const
+        {
+            BOOST_ASSERT(!"non numeric column vector in row array fetch");
+        }
+
+        result& res_;
+        array_column& arr_;
+        SQLUSMALLINT col_;
+        size_t n_;
+    };
+
+    // Move fetched values from bound storage into column vector
+    struct copy_array : boost::static_visitor<>
+    {
+        copy_array(const array_column& arr, column_buffer& buf, size_t rows)
+          : arr_(arr), buf_(buf), rows_(rows)
+        {}
+
+        template<typename T>
+        void operator()(std::vector<T>* v, typename boost::enable_if< boost::is_arithmetic<T> >::type* = 0) const
+        {
+            typedef typename array_c_type<T>::type storage_type;
+            const storage_type* data = rows_ ? reinterpret_cast<const storage_type*>(&arr_.data_[0]) : 0;
+
+            for (size_t row = 0; row < rows_; ++row)
+            {
+                if (SQL_NULL_DATA == arr_.indicators_[row])
+                {
+                    v->push_back(T());
+                    ++buf_.null_count;
+                }
+                else
+                {
+                    v->push_back(static_cast<T>(data[row]));
+                    buf_.set_valid(row);
+                }
+            }
+        }
+
+        template<typename T>
+        void operator()(std::vector<T>*, typename boost::disable_if< boost::is_arithmetic<T> >::type* = 0) const
+        {
+        }
+
+        const array_column& arr_;
+        column_buffer& buf_;
+        size_t rows_;
+    };
+
     SQLHSTMT stmt_;
     bool wide_;
     int fetch_col_;
     columns_set columns_;
     vector<char> column_char_buf_;
+    vector<string> ref_values_;
+    vector< vector<unsigned char> > blob_values_;
     error_checker throw_on_error_;
 };
 
@@ -658,7 +880,7 @@ public:
     {
         holder_sp value;
         const param_desc& desc = get_param_desc(bind_col_, s_generic_varchar_desc);
-        bool bind_as_wchar = desc.data_type_ == SQL_WVARCHAR || desc.data_type_ == SQL_WVARCHAR || desc.data_type_ == SQL_WLONGVARCHAR;
+        bool bind_as_wchar = desc.data_type_ == SQL_WCHAR || desc.data_type_ == SQL_WVARCHAR || desc.data_type_ == SQL_WLONGVARCHAR;
 
         if(bind_as_wchar)
         {
@@ -677,6 +899,21 @@ public:
         return value;
     }
 
+    holder_sp operator()(const borrowed_string& v)
+    {
+        const param_desc& desc = get_param_desc(bind_col_, s_generic_varchar_desc);
+        bool bind_as_wchar = desc.data_type_ == SQL_WCHAR || desc.data_type_ == SQL_WVARCHAR || desc.data_type_ == SQL_WLONGVARCHAR;
+
+        // Wide parameters require conversion, bind them as ordinary strings
+        if(bind_as_wchar)
+            return (*this)(static_cast<const string_ref&>(v));
+
+        // Holder keeps only length indicator, data is referenced directly, see by_ref
+        holder_sp value = boost::make_shared<holder>();
+        do_bind(SQL_C_CHAR, desc, v.empty() ? "" : v.begin(), v.size(), value->first);
+        return value;
+    }
+
     holder_sp operator()(const tm& v)
     {
         holder_sp value = boost::make_shared<holder>(0, format_time(v));
@@ -690,6 +927,49 @@ public:
         return value;
     }
 
+    holder_sp operator()(const timestamp& v)
+    {
+        param_desc desc = get_param_desc(bind_col_, s_generic_timestamp_desc);
+        if (desc.data_type_ != SQL_TYPE_TIMESTAMP)
+            desc = s_generic_timestamp_desc;
+
+        // Drivers reject fraction that has more digits than parameter precision
+        int scale = 1;
+        for (int i = desc.decimal_digits_; i < 6; ++i)
+            scale *= 10;
+
+        int us = v.fraction() - v.fraction() % scale;
+
+        std::tm t = v.to_tm();
+        TIMESTAMP_STRUCT tmp;
+        tmp.year = SQLSMALLINT(t.tm_year + 1900);
+        tmp.month = SQLUSMALLINT(t.tm_mon + 1);
+        tmp.day = SQLUSMALLINT(t.tm_mday);
+        tmp.hour = SQLUSMALLINT(t.tm_hour);
+        tmp.minute = SQLUSMALLINT(t.tm_min);
+        tmp.second = SQLUSMALLINT(t.tm_sec);
+        tmp.fraction = SQLUINTEGER(us) * 1000;
+
+        holder_sp value = boost::make_shared<holder>(0, string((const char*)&tmp, sizeof(tmp)));
+        do_bind(false, SQL_C_TYPE_TIMESTAMP, desc, *value);
+        return value;
+    }
+
+    holder_sp operator()(const blob_ref& v)
+    {
+        holder_sp value = boost::make_shared<holder>(0, string(v.data(), v.size()));
+        do_bind(false, SQL_C_BINARY, get_param_desc(bind_col_, s_generic_varbinary_desc), *value);
+        return value;
+    }
+
+    holder_sp operator()(const borrowed_blob& v)
+    {
+        // Holder keeps only length indicator, data is referenced directly, see by_ref
+        holder_sp value = boost::make_shared<holder>();
+        do_bind(SQL_C_BINARY, get_param_desc(bind_col_, s_generic_varbinary_desc), v.empty() ? "" : v.data(), v.size(), value->first);
+        return value;
+    }
+
     holder_sp operator()(istream* v)
     {
         const param_desc& desc = get_param_desc(bind_col_, s_generic_varbinary_desc);
@@ -869,35 +1149,41 @@ private:
         }
         else
         {
-            value.first = value.second.size();
-            size_t column_size = desc.param_size_;
-
-            // Mumbo-jumbo with column size
-            // I hate ODBC. Some related docs
-            // http://msdn.microsoft.com/en-us/library/ms711786(v=vs.85).aspx
-
-            if(ctype == SQL_C_WCHAR)
-                column_size = value.second.size()/2;
-            else if(ctype == SQL_C_CHAR)
-                column_size = value.second.size();
-
-            if(value.second.empty())
-                column_size = 1;
-
-            throw_on_error_("SQLBindParameter") = SQLBindParameter(
-                stmt_.get(),
-                bind_col_,
-                SQL_PARAM_INPUT,
-                ctype,
-                desc.data_type_,
-                column_size,                    // Column size
-                desc.decimal_digits_,           // Precision
-                (void*)value.second.c_str(),    // string
-                value.second.size(),
-                &value.first);
+            do_bind(ctype, desc, value.second.c_str(), value.second.size(), value.first);
         }
     }
 
+    // Bind data that is owned by caller, ODBC driver reads it during execution
+    void do_bind(SQLSMALLINT ctype, const param_desc& desc, const char* data, size_t size, SQLLEN& len)
+    {
+        len = size;
+        size_t column_size = desc.param_size_;
+
+        // Mumbo-jumbo with column size
+        // I hate ODBC. Some related docs
+        // http://msdn.microsoft.com/en-us/library/ms711786(v=vs.85).aspx
+
+        if(ctype == SQL_C_WCHAR)
+            column_size = size/2;
+        else if(ctype == SQL_C_CHAR)
+            column_size = size;
+
+        if(!size)
+            column_size = 1;
+
+        throw_on_error_("SQLBindParameter") = SQLBindParameter(
+            stmt_.get(),
+            bind_col_,
+            SQL_PARAM_INPUT,
+            ctype,
+            desc.data_type_,
+            column_size,                    // Column size
+            desc.decimal_digits_,           // Precision
+            (void*)data,                    // string
+            size,
+            &len);
+    }
+
 private:
     // Read only members, filled during constructions
 
@@ -921,10 +1207,12 @@ private:
 
     static param_desc s_generic_varchar_desc;
     static param_desc s_generic_varbinary_desc;
+    static param_desc s_generic_timestamp_desc;
 };
 
 statement::param_desc statement::s_generic_varchar_desc = {SQL_CHAR, 0, 0, 1};
 statement::param_desc statement::s_generic_varbinary_desc = {SQL_BINARY, 0, 0, 1};
+statement::param_desc statement::s_generic_timestamp_desc = {SQL_TYPE_TIMESTAMP, 26, 6, 1};
 
 class connection : public backend::connection, private common_data
 {
@@ -10,6 +10,8 @@
 #include <boost/type_traits/is_signed.hpp>
 #include <boost/type_traits/is_unsigned.hpp>
 #include <boost/type_traits/is_floating_point.hpp>
+#include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/type_traits/is_same.hpp>
 #include <boost/move/move.hpp>
 #include <boost/container/vector.hpp>
 #include <boost/mpl/switch.hpp>
@@ -159,10 +161,26 @@ struct column
             SQLT_BLOB == type_ )
         {
             ec = OCIDescriptorAlloc(envhp, lob_.ptr().as_void(), OCI_DTYPE_LOB, 0, 0);
+        }
+        else
+        {
+            // Allocate data for output value
+            data_.resize(eval_alloc_size(col_length));
+        }
+
+        define(stmtp, errp, idx - 1);
+    }
 
+    // Define single row output value, also restores define after array fetch
+    void define(OCIStmt* stmtp, OCIError* errp, ub4 idx)
+    {
+        error_checker ec(errp);
+
+        if (is_lob())
+        {
             ec = OCIDefineByPos(
                 stmtp, define_.ptr(), errp, 
-                idx, 
+                idx + 1, 
                 &lob_, sizeof(lob_), type_,
                 &col_fetch_ind_, &col_fetch_size_, &col_fetch_rcode_, 
                 OCI_DEFAULT 
@@ -170,12 +188,9 @@ struct column
         }
         else
         {
-            // Allocate data, and define output value
-            data_.resize(eval_alloc_size(col_length));
-
             ec = OCIDefineByPos(
                 stmtp, define_.ptr(), errp, 
-                idx, 
+                idx + 1, 
                 &data_[0], data_.size(), type_,
                 &col_fetch_ind_, &col_fetch_size_, &col_fetch_rcode_, 
                 OCI_DEFAULT 
@@ -200,6 +215,16 @@ private:
     }    
 };
 
+// Return true for column vectors that can be defined for array fetch of NUMBER column
+struct is_array_fetchable : boost::static_visitor<bool>
+{
+    template<typename T>
+    bool operator()(std::vector<T>*) const
+    {
+        return boost::is_arithmetic<T>::value && !boost::is_same<T, long double>::value;
+    }
+};
+
 class result : public backend::result, public boost::static_visitor<>
 {
     typedef boost::integral_constant<int, SQLT_FLT> sqlt_flt_tag;
@@ -288,6 +313,62 @@ public:
         return status != OCI_NO_DATA;
     }
 
+    virtual std::size_t fetch_batch(std::size_t n, std::vector<column_buffer>& buffers)
+    {
+        // Array fetch fills every defined column, so it is used only when each column of result is NUMBER
+        // requested into numeric vector. Other batches are fetched row by row.
+        std::vector<column_buffer*> targets(columns_size_, (column_buffer*)0);
+        bool native = n > 0 && buffers.size() == columns_size_;
+
+        is_array_fetchable fetchable;
+        BOOST_FOREACH(column_buffer& b, buffers)
+        {
+            if (b.column < 0 || (ub4)b.column >= columns_size_)
+                throw invalid_column(b.column);
+
+            if (targets[b.column] || SQLT_VNU != columns_[b.column].type_ || !b.values.apply_visitor(fetchable))
+                native = false;
+
+            targets[b.column] = &b;
+        }
+
+        if (!native)
+            return backend::result::fetch_batch(n, buffers);
+
+        std::vector< std::vector<sb2> > indicators(columns_size_, std::vector<sb2>(n));
+        ub4 fetched = 0;
+
+        {
+            array_fetch_guard guard(*this);
+
+            for (ub4 i = 0; i < columns_size_; ++i)
+            {
+                targets[i]->reset(n);
+                define_array definer(*this, i, &indicators[i][0], n);
+                targets[i]->values.apply_visitor(definer);
+            }
+
+            // OCI_NO_DATA is returned when less than n rows were fetched
+            throw_on_error_ = OCIStmtFetch2(
+                stmtp_, throw_on_error_.errhp_, (ub4)n, just_initialized_ ? OCI_FETCH_FIRST : OCI_FETCH_NEXT, 0, OCI_DEFAULT
+              );
+
+            just_initialized_ = false;
+
+            throw_on_error_ = OCIAttrGet(
+                stmtp_, OCI_HTYPE_STMT, &fetched, 0, OCI_ATTR_ROWS_FETCHED, throw_on_error_.errhp_
+              );
+        }
+
+        for (ub4 i = 0; i < columns_size_; ++i)
+        {
+            finish_array finisher(indicators[i], *targets[i], fetched);
+            targets[i]->values.apply_visitor(finisher);
+        }
+
+        return fetched;
+    }
+
     bool fetch(int col, const fetch_types_variant& v)
     {
         if (is_null(col)) 
@@ -326,6 +407,28 @@ public:
     }
 
     void operator()(std::string* v)
+    {
+        string_ref tmp;
+        (*this)(&tmp);
+        v->assign(tmp.begin(), tmp.end());
+    }
+
+    void operator()(std::vector<unsigned char>* v)
+    {
+        string_ref tmp;
+        (*this)(&tmp);
+        v->assign(tmp.begin(), tmp.end());
+    }
+
+    void operator()(blob_ref* v)
+    {
+        string_ref tmp;
+        (*this)(&tmp);
+        *v = blob_ref(tmp.begin(), tmp.size());
+    }
+
+    // Lob content is read into column buffer, so the view is valid until next row
+    void operator()(string_ref* v)
     {
         column& c = columns_[fetch_col_];
 
@@ -336,7 +439,7 @@ public:
 
             if (!lob_len_max) 
             {
-                v->clear();
+                *v = string_ref();
                 return;
             }
 
@@ -361,10 +464,10 @@ public:
               , 0, 0, 0, 0
               );
 
-              v->assign(c.data_.begin(), c.data_.begin() + (size_t)lob_len_bytes);
+              *v = string_ref(&c.data_[0], (size_t)lob_len_bytes);
         }
         else 
-            v->assign(&c.data_[0], c.col_fetch_size_);
+            *v = string_ref(&c.data_[0], c.col_fetch_size_);
     }
 
     void operator()(std::ostream* v)
@@ -409,6 +512,13 @@ public:
     }
 
     void operator()(std::tm* v)
+    {
+        timestamp tmp;
+        (*this)(&tmp);
+        *v = tmp.to_tm();
+    }
+
+    void operator()(timestamp* v)
     {
         if (SQLT_DAT != columns_[fetch_col_].type_)
             throw invalid_column(fetch_col_);
@@ -442,16 +552,12 @@ public:
             envhp_, throw_on_error_.errhp_, dt.get(), &hour, &min, &sec, &sec_frac
           );
 
-	    v->tm_year  = year - 1900;
-	    v->tm_mon   = month - 1;
-        v->tm_mday  = day;
-        v->tm_hour  = hour;
-        v->tm_min   = min;
-	    v->tm_sec   = static_cast<int>(sec);
-	    v->tm_isdst = -1;
+        if (month < 1 || month > 12)
+            throw bad_value_cast();
 
-	    if (mktime(v) == -1)
-		    throw bad_value_cast();
+        // sec_frac is in nanoseconds
+        boost::int64_t seconds = days_from_civil(year, month, day) * 86400 + hour * 3600 + min * 60 + sec;
+        *v = timestamp(seconds * 1000000 + sec_frac / 1000);
     }
 
     virtual bool is_null(int col)
@@ -488,6 +594,88 @@ public:
     }
 
 private:
+    // Restore single row defines after array fetch
+    struct array_fetch_guard
+    {
+        array_fetch_guard(result& res) : res_(res) {}
+
+        ~array_fetch_guard()
+        {
+            try
+            {
+                for (ub4 i = 0; i < res_.columns_size_; ++i)
+                    res_.columns_[i].define(res_.stmtp_, res_.throw_on_error_.errhp_, i);
+            }
+            catch(...)
+            {
+            }
+        }
+
+        result& res_;
+    };
+
+    // Define column vector as output array of n values
+    struct define_array : boost::static_visitor<>
+    {
+        define_array(result& res, ub4 col, sb2* indicators, size_t n)
+          : res_(res), col_(col), indicators_(indicators), n_(n)
+        {}
+
+        template<typename T>
+        void operator()(std::vector<T>* v, typename boost::enable_if< boost::is_arithmetic<T> >::type* = 0) const
+        {
+            ub2 type = boost::is_floating_point<T>::value ? SQLT_FLT : (boost::is_signed<T>::value ? SQLT_INT : SQLT_UIN);
+
+            v->resize(n_);
+            res_.throw_on_error_ = OCIDefineByPos(
+                res_.stmtp_, res_.columns_[col_].define_.ptr(), res_.throw_on_error_.errhp_,
+                col_ + 1,
+                &(*v)[0], sizeof(T), type,
+                indicators_, 0, 0,
+                OCI_DEFAULT
+                );
+        }
+
+        template<typename T>
+        void operator()(std::vector<T>*, typename boost::disable_if< boost::is_arithmetic<T> >::type* = 0) const
+        {
+            BOOST_ASSERT(!"non numeric column vector in array fetch");
+        }
+
+        result& res_;
+        ub4 col_;
+        sb2* indicators_;
+        size_t n_;
+    };
+
+    // Cut column vector to number of fetched rows and fill validity bitmap
+    struct finish_array : boost::static_visitor<>
+    {
+        finish_array(const std::vector<sb2>& indicators, column_buffer& buf, ub4 rows)
+          : indicators_(indicators), buf_(buf), rows_(rows)
+        {}
+
+        template<typename T>
+        void operator()(std::vector<T>* v) const
+        {
+            v->resize(rows_);
+            for (ub4 row = 0; row < rows_; ++row)
+            {
+                if (-1 == indicators_[row])
+                {
+                    (*v)[row] = T();
+                    ++buf_.null_count;
+                }
+                else
+                    buf_.set_valid(row);
+            }
+        }
+
+        const std::vector<sb2>& indicators_;
+        column_buffer& buf_;
+        ub4 rows_;
+    };
+
     void convert_number_to_type(const void* number, sqlt_flt_tag, void* out, size_t out_len)
     {
         const OCINumber* n = reinterpret_cast<const OCINumber*>(number);
@@ -586,6 +774,13 @@ public:
 
     void operator()(const std::tm& v)
     {
+        (*this)(timestamp::from_tm(v));
+    }
+
+    void operator()(const timestamp& v)
+    {
+        std::tm t = v.to_tm();
+
         oci_desc_datetime dt;
         throw_on_error_ = OCIDescriptorAlloc(cd_->envhp_.get(), dt.ptr().as_void(), OCI_DTYPE_TIMESTAMP, 0, 0);
         dt_holder_.push_back(boost::move(dt));
@@ -594,24 +789,40 @@ public:
             cd_->envhp_.get()
           , throw_on_error_.errhp_
           , dt_holder_.back().get()
-          , v.tm_year + 1900
-          , v.tm_mon + 1
-          , v.tm_mday
-          , v.tm_hour
-          , v.tm_min
-          , v.tm_sec
-          , 0
+          , sb2(t.tm_year + 1900)
+          , ub1(t.tm_mon + 1)
+          , ub1(t.tm_mday)
+          , ub1(t.tm_hour)
+          , ub1(t.tm_min)
+          , ub1(t.tm_sec)
+          , ub4(v.fraction()) * 1000
           , 0, 0
           );
 
         do_bind(&dt_holder_.back(), sizeof(OCIDateTime*), SQLT_TIMESTAMP);
     }
 
+    // Temporary lob is written with single call, OCI reads directly from caller buffer
+    void operator()(const blob_ref& v)
+    {
+        oci_desc_lob lob;
+        create_temporary_lob(lob);
+
+        if (!v.empty())
+        {
+            oraub8 bytes = static_cast<oraub8>(v.size());
+            throw_on_error_ = OCILobWriteAppend2(cd_->svcp_.get(), throw_on_error_.errhp_, lob.get(), &bytes, 0, (void*)v.data(), bytes, OCI_ONE_PIECE, 0, 0, OCI_DEFAULT, SQLCS_IMPLICIT);
+        }
+
+        lob_holder_.push_back(boost::move(lob));
+
+        do_bind(&lob_holder_.back(), sizeof(OCILobLocator*), SQLT_BLOB);
+    }
+
     void operator()(std::istream* v) 
     {
         oci_desc_lob lob;
-        throw_on_error_ = OCIDescriptorAlloc(cd_->envhp_.get(), lob.ptr().as_void(), OCI_DTYPE_LOB, 0, 0);
-        throw_on_error_ = OCILobCreateTemporary(cd_->svcp_.get(), throw_on_error_.errhp_, lob.get(), OCI_DEFAULT, OCI_DEFAULT, OCI_TEMP_BLOB, FALSE, OCI_DURATION_STATEMENT);
+        create_temporary_lob(lob);
         
         ub4 chunk_size;
         throw_on_error_ = OCILobGetChunkSize(cd_->svcp_.get(), throw_on_error_.errhp_, lob.get(), &chunk_size);
@@ -694,6 +905,12 @@ public:
     }
 
 private:    
+    void create_temporary_lob(oci_desc_lob& lob)
+    {
+        throw_on_error_ = OCIDescriptorAlloc(cd_->envhp_.get(), lob.ptr().as_void(), OCI_DTYPE_LOB, 0, 0);
+        throw_on_error_ = OCILobCreateTemporary(cd_->svcp_.get(), throw_on_error_.errhp_, lob.get(), OCI_DEFAULT, OCI_DEFAULT, OCI_TEMP_BLOB, FALSE, OCI_DURATION_STATEMENT);
+    }
+
     void do_bind(const void *v, size_t len, ub2 type) 
     {        
         // remember data to bind it later
@@ -5,6 +5,7 @@
 #include <edba/errors.hpp>
 
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/scope_exit.hpp>
 #include <boost/foreach.hpp>
 
@@ -18,6 +19,13 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+
+#ifdef _WIN32
+#  include <winsock2.h>
+#else
+#  include <poll.h>
+#endif
 
 namespace edba { namespace backend { namespace postgres { namespace {
 
@@ -77,6 +85,48 @@ public:
     }
 };
 
+/// Wait until connection socket becomes readable, or also writable when \a output is set. Zero \a timeout_ms means
+/// don`t wait, negative means wait infinitely, otherwise wait until \a deadline. Return false if timeout has expired.
+bool wait_for_socket(PGconn* conn, bool output, int timeout_ms, const boost::posix_time::ptime& deadline)
+{
+    using namespace boost::posix_time;
+
+    if(timeout_ms == 0)
+        return false;
+
+    int sock = PQsocket(conn);
+    if(sock < 0)
+        throw pqerror("connection socket is not available");
+
+    int wait_ms = -1;
+    if(timeout_ms > 0)
+    {
+        time_duration left = deadline - microsec_clock::universal_time();
+        if(left.is_negative())
+            return false;
+
+        wait_ms = static_cast<int>(left.total_milliseconds());
+    }
+
+    // poll has no limit on descriptor value unlike select with fd_set of FD_SETSIZE
+    pollfd pfd;
+    pfd.fd = sock;
+    pfd.events = POLLIN | (output ? POLLOUT : 0);
+    pfd.revents = 0;
+
+#ifdef _WIN32
+    int rc = WSAPoll(&pfd, 1, wait_ms);
+    if(rc < 0)
+        throw pqerror("WSAPoll() failed while waiting for server response");
+#else
+    int rc = poll(&pfd, 1, wait_ms);
+    if(rc < 0 && errno != EINTR)
+        throw pqerror("poll() failed while waiting for server response");
+#endif
+
+    return rc != 0;
+}
+
 class result : public backend::result, public boost::static_visitor<>
 {
 public:
@@ -85,7 +135,8 @@ public:
       conn_(conn),
       rows_(PQntuples(res)),
       cols_(PQnfields(res)),
-      current_(-1)
+      current_(-1),
+      blob_buffers_(cols_)
     {
     }
 
@@ -130,7 +181,44 @@ public:
         v->assign(PQgetvalue(res_, current_, fetch_col_),PQgetlength(res_, current_, fetch_col_));
     }
 
+    void operator()(string_ref* v)
+    {
+        *v = string_ref(PQgetvalue(res_, current_, fetch_col_), PQgetlength(res_, current_, fetch_col_));
+    }
+
     void operator()(std::ostream* v)
+    {
+        read_blob(*v);
+    }
+
+    void operator()(std::vector<unsigned char>* v)
+    {
+        v->clear();
+        vector_writer out = { *v };
+        read_blob(out);
+    }
+
+    // Unescaped content is kept in per column buffer until next row
+    void operator()(blob_ref* v)
+    {
+        std::vector<unsigned char>& buf = blob_buffers_[fetch_col_];
+        (*this)(&buf);
+        *v = blob_ref(buf);
+    }
+
+    struct vector_writer
+    {
+        std::vector<unsigned char>& v_;
+
+        void write(const char* data, std::size_t size)
+        {
+            v_.insert(v_.end(), data, data + size);
+        }
+    };
+
+    // Read bytea, large object or plain text value of current column into \a v
+    template<typename Out>
+    void read_blob(Out& v)
     {
         switch(PQftype(res_, fetch_col_))
         {
@@ -142,11 +230,11 @@ public:
                 if(!buf)
                     throw bad_value_cast();
 
-                BOOST_SCOPE_EXIT((buf)) {
+                BOOST_SCOPE_EXIT_TPL((buf)) {
                     PQfreemem(buf);
                 } BOOST_SCOPE_EXIT_END
 
-                v->write((char *)buf,len);
+                v.write((char *)buf,len);
                 break;
             }
             case OID_IDENTIFIER_TYPE: {
@@ -161,7 +249,7 @@ public:
                 if(fd < 0)
                     throw pqerror(conn_, "Failed opening large object for read");
 
-                BOOST_SCOPE_EXIT((conn_)(fd)) {
+                BOOST_SCOPE_EXIT_TPL((conn_)(fd)) {
                     lo_close(conn_, fd);
                 } BOOST_SCOPE_EXIT_END
 
@@ -173,7 +261,7 @@ public:
                         throw pqerror(conn_, "Failed reading large object");
 
                     if(n >= 0)
-                        v->write(buf,n);
+                        v.write(buf,n);
 
                     if(n < int(sizeof(buf)))
                         break;
@@ -182,7 +270,7 @@ public:
                 break;
             }
             default: {
-                v->write(PQgetvalue(res_, current_, fetch_col_), PQgetlength(res_, current_, fetch_col_));
+                v.write(PQgetvalue(res_, current_, fetch_col_), PQgetlength(res_, current_, fetch_col_));
             }
         }
     }
@@ -192,6 +280,12 @@ public:
         *v = parse_time(PQgetvalue(res_, current_, fetch_col_));
     }
 
+    void operator()(timestamp* v)
+    {
+        char const* s = PQgetvalue(res_, current_, fetch_col_);
+        *v = parse_timestamp(string_ref(s, s + PQgetlength(res_, current_, fetch_col_)));
+    }
+
     virtual bool is_null(int col)
     {
         return do_isnull(col);
@@ -239,6 +333,7 @@ private:
     int cols_;
     int current_;
     int fetch_col_;
+    std::vector< std::vector<unsigned char> > blob_buffers_;
 };
 
 class statement : public backend::statement, public boost::static_visitor<>
@@ -284,6 +379,8 @@ public:
       , params_pvalues_(bind_by_name_helper_.bindings_count(), 0)
       , params_plengths_(bind_by_name_helper_.bindings_count(), 0)
       , params_set_(bind_by_name_helper_.bindings_count(), null_param)
+      , async_done_(true)
+      , async_flushing_(false)
     {
         std::ostringstream ss;
         ss.imbue(std::locale::classic());
@@ -392,6 +489,39 @@ public:
         params_set_[bind_col_ - 1] = text_param;
     }
 
+    void operator()(const timestamp& v)
+    {
+        params_values_[bind_col_ - 1] = format_timestamp(v);
+        params_set_[bind_col_ - 1] = text_param;
+    }
+
+    void operator()(const blob_ref& v)
+    {
+        if(data_->blob_ == bytea_type)
+        {
+            // Passed to server as is in binary format
+            params_values_[bind_col_ - 1].assign(v.data(), v.size());
+            params_pvalues_[bind_col_ - 1] = 0;
+            params_set_[bind_col_ - 1] = binary_param;
+        }
+        else
+            bind_large_object(v, 0);
+    }
+
+    void operator()(const borrowed_blob& v)
+    {
+        if(data_->blob_ == bytea_type)
+        {
+            // Caller keeps data alive until execution, see by_ref. Empty value is taken from params_values_
+            params_values_[bind_col_ - 1].clear();
+            params_pvalues_[bind_col_ - 1] = v.empty() ? 0 : v.data();
+            params_plengths_[bind_col_ - 1] = v.size();
+            params_set_[bind_col_ - 1] = binary_param;
+        }
+        else
+            bind_large_object(v, 0);
+    }
+
     void operator()(std::istream* in)
     {
         if(data_->blob_ == bytea_type)
@@ -399,64 +529,82 @@ public:
             std::ostringstream ss;
             ss << in->rdbuf();
             params_values_[bind_col_ - 1] = ss.str();
+            params_pvalues_[bind_col_ - 1] = 0;
             params_set_[bind_col_ - 1] = binary_param;
         }
         else
-        {
-            Oid oid = InvalidOid;
+            bind_large_object(blob_ref(), in);
+    }
+
+    // Create large object with content of \a in, or \a data if \a in is null, and bind its oid
+    void bind_large_object(const blob_ref& data, std::istream* in)
+    {
+        Oid oid = InvalidOid;
 
-            // All lob operations should be inside transaction
-            // http://web.archiveorange.com/archive/v/KRdh2pENAWi9JrZH1bke
+        // All lob operations should be inside transaction
+        // http://web.archiveorange.com/archive/v/KRdh2pENAWi9JrZH1bke
+        if (!data_->inside_transaction_)
+            do_simple_exec(data_->conn_, "begin");
+
+        BOOST_SCOPE_EXIT((data_))
+        {
             if (!data_->inside_transaction_)
-                do_simple_exec(data_->conn_, "begin");
+            {
+                const char* query = std::uncaught_exception() ? "rollback" : "commit";
+                try { do_simple_exec(data_->conn_, query); }
+                catch(...) { }
+            }
+        } BOOST_SCOPE_EXIT_END
+
+        try
+        {
+            oid = lo_creat(data_->conn_, INV_READ | INV_WRITE);
+            if(InvalidOid == oid)
+                throw pqerror(data_->conn_, "failed to create large object");
+
+            int fd = lo_open(data_->conn_, oid, INV_WRITE);
+            if(fd < 0)
+                throw pqerror(data_->conn_, "failed to open large object for writing");
 
-            BOOST_SCOPE_EXIT((data_))
+            BOOST_SCOPE_EXIT((data_)(fd))
             {
-                if (!data_->inside_transaction_)
-                {
-                    const char* query = std::uncaught_exception() ? "rollback" : "commit";
-                    try { do_simple_exec(data_->conn_, query); }
-                    catch(...) { }
-                }
+                lo_close(data_->conn_, fd);
             } BOOST_SCOPE_EXIT_END
 
-            try
+            char buf[4096];
+            for(std::size_t offset = 0; ;)
             {
-                oid = lo_creat(data_->conn_, INV_READ | INV_WRITE);
-                if(InvalidOid == oid)
-                    throw pqerror(data_->conn_, "failed to create large object");
-
-                int fd = lo_open(data_->conn_, oid, INV_WRITE);
-                if(fd < 0)
-                    throw pqerror(data_->conn_, "failed to open large object for writing");
-
-                BOOST_SCOPE_EXIT((data_)(fd))
-                {
-                    lo_close(data_->conn_, fd);
-                } BOOST_SCOPE_EXIT_END
+                const char* chunk = buf;
+                std::streamsize bytes_read;
 
-                char buf[4096];
-                for(;;)
+                if(in)
                 {
                     in->read(buf, sizeof(buf));
-                    std::streamsize bytes_read = in->gcount();
-                    if(bytes_read > 0)
-                    {
-                        int n = lo_write(data_->conn_, fd, buf, (size_t)bytes_read);
-                        if(n < 0)
-                            throw pqerror(data_->conn_, "failed writing to large object");
-                    }
-                    if(bytes_read < int(sizeof(buf)))
-                        break;
+                    bytes_read = in->gcount();
+                }
+                else
+                {
+                    chunk = data.data() + offset;
+                    bytes_read = (std::min)(data.size() - offset, sizeof(buf));
+                    offset += (std::size_t)bytes_read;
                 }
 
-                bind(bind_col_, oid);
-            }
-            catch(...) {
-                if(oid != InvalidOid)
-                    lo_unlink(data_->conn_, oid);
-                throw;
+                if(bytes_read > 0)
+                {
+                    int n = lo_write(data_->conn_, fd, chunk, (size_t)bytes_read);
+                    if(n < 0)
+                        throw pqerror(data_->conn_, "failed writing to large object");
+                }
+                if(bytes_read < int(sizeof(buf)))
+                    break;
             }
+
+            bind(bind_col_, oid);
+        }
+        catch(...) {
+            if(oid != InvalidOid)
+                lo_unlink(data_->conn_, oid);
+            throw;
         }
     }
 
@@ -469,40 +617,10 @@ public:
 
     void real_query()
     {
-        char const * const *pvalues = 0;
-        int *plengths = 0;
-        int *pformats = 0;
         std::vector<char const *> values;
         std::vector<int> lengths;
         std::vector<int> formats;
-        if(bind_by_name_helper_.bindings_count() > 0)
-        {
-            values.resize(bind_by_name_helper_.bindings_count(),0);
-            lengths.resize(bind_by_name_helper_.bindings_count(),0);
-            formats.resize(bind_by_name_helper_.bindings_count(),0);
-            for(unsigned i = 0; i < bind_by_name_helper_.bindings_count(); i++)
-            {
-                if(params_set_[i]!=null_param)
-                {
-                    if(params_pvalues_[i]!=0)
-                    {
-                        values[i]=params_pvalues_[i];
-                        lengths[i]=params_plengths_[i];
-                    }
-                    else
-                    {
-                        values[i]=params_values_[i].c_str();
-                        lengths[i]=params_values_[i].size();
-                    }
-
-                    if(params_set_[i]==binary_param)
-                        formats[i]=1;
-                }
-            }
-            pvalues=&values.front();
-            plengths=&lengths.front();
-            pformats=&formats.front();
-        }
+        prepare_params(values, lengths, formats);
 
         if(res_)
         {
@@ -516,9 +634,9 @@ public:
                 patched_query().c_str(),
                 bind_by_name_helper_.bindings_count(),
                 0, // param types
-                pvalues,
-                plengths,
-                pformats, // format - text
+                values.empty() ? 0 : &values.front(),
+                lengths.empty() ? 0 : &lengths.front(),
+                formats.empty() ? 0 : &formats.front(), // format - text
                 0 // result format - text
                 );
         }
@@ -527,9 +645,9 @@ public:
                 data_->conn_,
                 prepared_id_.c_str(),
                 bind_by_name_helper_.bindings_count(),
-                pvalues,
-                plengths,
-                pformats, // format - text
+                values.empty() ? 0 : &values.front(),
+                lengths.empty() ? 0 : &lengths.front(),
+                formats.empty() ? 0 : &formats.front(), // format - text
                 0 // result format - text
                 );
         }
@@ -538,36 +656,146 @@ public:
     virtual backend::result_ptr query_impl()
     {
         real_query();
-        switch(PQresultStatus(res_))
-        {
-        case PGRES_TUPLES_OK:
+        return take_query_result();
+    }
+
+    virtual void exec_impl()
+    {
+        real_query();
+        check_exec_result();
+    }
+
+    virtual void async_start_impl(bool)
+    {
+        std::vector<char const *> values;
+        std::vector<int> lengths;
+        std::vector<int> formats;
+        prepare_params(values, lengths, formats);
+
+        if(res_)
         {
-            boost::intrusive_ptr<result> ptr(new result(res_, data_->conn_));
+            PQclear(res_);
             res_ = 0;
-            return ptr;
         }
-    break;
-        case PGRES_COMMAND_OK:
-            throw pqerror("Statement used instread of query");
-            break;
-        default:
-            throw pqerror(res_,"query execution failed ");
+
+        // In blocking mode PQsend* doesn`t return until the whole query is written to socket, that may take long for
+        // large parameters. In non-blocking mode the rest is kept in libpq output buffer and flushed by async_wait_impl
+        if(PQsetnonblocking(data_->conn_, 1) != 0)
+            throw pqerror(data_->conn_, "failed to switch connection to non-blocking mode");
+
+        int sent;
+        if(prepared_id_.empty()) {
+            sent = PQsendQueryParams(
+                data_->conn_,
+                patched_query().c_str(),
+                bind_by_name_helper_.bindings_count(),
+                0, // param types
+                values.empty() ? 0 : &values.front(),
+                lengths.empty() ? 0 : &lengths.front(),
+                formats.empty() ? 0 : &formats.front(), // format - text
+                0 // result format - text
+                );
+        }
+        else {
+            sent = PQsendQueryPrepared(
+                data_->conn_,
+                prepared_id_.c_str(),
+                bind_by_name_helper_.bindings_count(),
+                values.empty() ? 0 : &values.front(),
+                lengths.empty() ? 0 : &lengths.front(),
+                formats.empty() ? 0 : &formats.front(), // format - text
+                0 // result format - text
+                );
         }
+
+        if(!sent)
+        {
+            pqerror e(data_->conn_, "failed to send query");
+            PQsetnonblocking(data_->conn_, 0);
+            throw e;
+        }
+
+        async_done_ = false;
+        async_flushing_ = true;
     }
-    virtual void exec_impl()
+
+    virtual bool async_wait_impl(int timeout_ms)
     {
-        real_query();
-        switch(PQresultStatus(res_))
+        using namespace boost::posix_time;
+
+        ptime deadline = microsec_clock::universal_time() + milliseconds(timeout_ms);
+
+        try
         {
-        case PGRES_TUPLES_OK:
-            throw pqerror("Query used instead of statement");
-            break;
-        case PGRES_COMMAND_OK:
-            break;
-        default:
-            throw pqerror(res_,"statement execution failed ");
+            while(!async_done_)
+            {
+                // Server may start answering before it has read the whole query, so input is consumed while flushing too
+                if(async_flushing_)
+                {
+                    int rc = PQflush(data_->conn_);
+                    if(rc < 0)
+                        throw pqerror(data_->conn_, "failed to send query");
+
+                    async_flushing_ = rc != 0;
+                }
+
+                if(!PQconsumeInput(data_->conn_))
+                    throw pqerror(data_->conn_, "failed to read query result");
+
+                if(!async_flushing_ && !PQisBusy(data_->conn_))
+                {
+                    // Keep the first result, the others may appear only for multistatement queries
+                    while(PGresult* r = PQgetResult(data_->conn_))
+                    {
+                        if(res_)
+                            PQclear(r);
+                        else
+                            res_ = r;
+                    }
+
+                    // Synchronous calls expect blocking connection
+                    PQsetnonblocking(data_->conn_, 0);
+                    async_done_ = true;
+                    break;
+                }
+
+                if(!wait_for_socket(data_->conn_, async_flushing_, timeout_ms, deadline))
+                    break;
+            }
+        }
+        catch(...)
+        {
+            // Like failed send in async_start_impl, leave connection usable by synchronous calls
+            PQsetnonblocking(data_->conn_, 0);
+            async_flushing_ = false;
+            async_done_ = true;
+            throw;
         }
+
+        return async_done_;
     }
+
+    virtual bool async_wants_write_impl()
+    {
+        return async_flushing_;
+    }
+
+    virtual backend::result_ptr async_query_result_impl()
+    {
+        if(!res_)
+            throw pqerror(data_->conn_, "query execution failed");
+
+        return take_query_result();
+    }
+
+    virtual void async_exec_result_impl()
+    {
+        if(!res_)
+            throw pqerror(data_->conn_, "statement execution failed");
+
+        check_exec_result();
+    }
+
     virtual long long sequence_last(std::string const &sequence)
     {
         PGresult *res = 0;
@@ -624,6 +852,65 @@ private:
             throw invalid_column(col - 1);
     }
 
+    void prepare_params(std::vector<char const *>& values, std::vector<int>& lengths, std::vector<int>& formats)
+    {
+        if(bind_by_name_helper_.bindings_count() == 0)
+            return;
+
+        values.resize(bind_by_name_helper_.bindings_count(),0);
+        lengths.resize(bind_by_name_helper_.bindings_count(),0);
+        formats.resize(bind_by_name_helper_.bindings_count(),0);
+        for(unsigned i = 0; i < bind_by_name_helper_.bindings_count(); i++)
+        {
+            if(params_set_[i]!=null_param)
+            {
+                if(params_pvalues_[i]!=0)
+                {
+                    values[i]=params_pvalues_[i];
+                    lengths[i]=params_plengths_[i];
+                }
+                else
+                {
+                    values[i]=params_values_[i].c_str();
+                    lengths[i]=params_values_[i].size();
+                }
+
+                if(params_set_[i]==binary_param)
+                    formats[i]=1;
+            }
+        }
+    }
+
+    backend::result_ptr take_query_result()
+    {
+        switch(PQresultStatus(res_))
+        {
+        case PGRES_TUPLES_OK:
+        {
+            boost::intrusive_ptr<result> ptr(new result(res_, data_->conn_));
+            res_ = 0;
+            return ptr;
+        }
+        case PGRES_COMMAND_OK:
+            throw pqerror("Statement used instread of query");
+        default:
+            throw pqerror(res_,"query execution failed ");
+        }
+    }
+
+    void check_exec_result()
+    {
+        switch(PQresultStatus(res_))
+        {
+        case PGRES_TUPLES_OK:
+            throw pqerror("Query used instead of statement");
+        case PGRES_COMMAND_OK:
+            break;
+        default:
+            throw pqerror(res_,"statement execution failed ");
+        }
+    }
+
     detail::bind_by_name_helper bind_by_name_helper_;
     const common_data* data_;
     PGresult *res_;
@@ -634,6 +921,8 @@ private:
     std::vector<size_t> params_plengths_;
     std::vector<param_type> params_set_;
     int bind_col_;
+    bool async_done_;
+    bool async_flushing_;
 };
 
 class connection : public backend::connection, private common_data
@@ -757,7 +1046,59 @@ public:
     {
         return description_;
     }
+
+    virtual void listen(const string_ref& channel)
+    {
+        statement::do_simple_exec(conn_, ("LISTEN " + escape_identifier(channel)).c_str());
+    }
+
+    virtual void unlisten(const string_ref& channel)
+    {
+        statement::do_simple_exec(conn_, ("UNLISTEN " + escape_identifier(channel)).c_str());
+    }
+
+    virtual bool wait_notification(notification& n, int timeout_ms)
+    {
+        using namespace boost::posix_time;
+
+        ptime deadline = microsec_clock::universal_time() + milliseconds(timeout_ms);
+
+        do
+        {
+            if(!PQconsumeInput(conn_))
+                throw pqerror(conn_, "failed to read notifications");
+
+            if(PGnotify* nf = PQnotifies(conn_))
+            {
+                n.channel = nf->relname;
+                n.payload = nf->extra ? nf->extra : "";
+                n.backend_pid = nf->be_pid;
+                PQfreemem(nf);
+                return true;
+            }
+        }
+        while(wait_for_socket(conn_, false, timeout_ms, deadline));
+
+        return false;
+    }
+
+    virtual int native_socket()
+    {
+        return PQsocket(conn_);
+    }
+
 private:
+    std::string escape_identifier(const string_ref& s)
+    {
+        char* escaped = PQescapeIdentifier(conn_, s.begin(), s.size());
+        if(!escaped)
+            throw pqerror(conn_, "failed to escape identifier");
+
+        std::string res(escaped);
+        PQfreemem(escaped);
+        return res;
+    }
+
     unsigned long long prepared_id_;
     std::string description_;
 };
@@ -1,15 +1,19 @@
 #include <edba/backend/implementation_base.hpp>
+#include <edba/sqlite3.hpp>
 
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/type_traits/is_signed.hpp>
 #include <boost/type_traits/is_unsigned.hpp>
 #include <boost/type_traits/is_floating_point.hpp>
 #include <boost/foreach.hpp>
+#include <boost/scoped_ptr.hpp>
 
+#include <algorithm>
 #include <sstream>
 #include <limits>
 #include <iomanip>
 #include <map>
+#include <new>
 
 #include <sqlite3.h>
 
@@ -24,13 +28,24 @@ int g_ver_major = (sqlite3_libversion_number() / 1000) % 1000;
 int g_ver_minor = sqlite3_libversion_number() % 1000;
 std::string g_description = std::string("SQLite Version ") + sqlite3_libversion();
 
+// Defaults applied by profile=throughput, explicitly specified properties take precedence
+const char* const g_throughput_profile[][2] = {
+    {"journal_mode", "wal"}
+  , {"synchronous", "normal"}
+  , {"temp_store", "memory"}
+  , {"cache_size", "-65536"}        // 64MB
+  , {"mmap_size", "268435456"}      // 256MB
+  , {"busy_timeout", "5000"}
+};
+
 class result : public backend::result, public boost::static_visitor<>
 {
 public:
-    result(sqlite3_stmt *st, sqlite3 *conn) :
+    result(sqlite3_stmt *st, ::sqlite3 *conn) :
         st_(st),
         conn_(conn),
-        cols_(-1)
+        cols_(-1),
+        done_(false)
     {
         cols_ = sqlite3_column_count(st_);
     }
@@ -46,9 +61,15 @@ public:
 
     virtual bool next()
     {
+        // Stepping statement after SQLITE_DONE would restart it
+        if(done_)
+            return false;
+
         int r = sqlite3_step(st_);
-        if(r==SQLITE_DONE)
+        if(r==SQLITE_DONE) {
+            done_ = true;
             return false;
+        }
         if(r!=SQLITE_ROW) {
             throw edba_error(std::string("sqlite3:") + sqlite3_errmsg(conn_));
         }
@@ -68,6 +89,45 @@ public:
         return true;
     }
 
+    virtual std::size_t fetch_batch(std::size_t n, std::vector<column_buffer>& buffers)
+    {
+        // Resolve reader for every buffer once, so loop below doesn`t visit variant for each cell
+        resolve_reader resolver;
+        std::vector<batch_reader> readers;
+        readers.reserve(buffers.size());
+        BOOST_FOREACH(column_buffer& b, buffers)
+        {
+            if(b.column < 0 || b.column >= cols_)
+                throw invalid_column(b.column);
+
+            b.reset(n);
+            readers.push_back(b.values.apply_visitor(resolver));
+        }
+
+        std::size_t row = 0;
+        for(; row < n && next(); ++row)
+        {
+            for(std::size_t i = 0; i < buffers.size(); ++i)
+            {
+                column_buffer& b = buffers[i];
+                fetch_col_ = b.column;
+
+                if(sqlite3_column_type(st_, fetch_col_) == SQLITE_NULL)
+                {
+                    (this->*readers[i].read_)(readers[i].values_, true);
+                    ++b.null_count;
+                }
+                else
+                {
+                    (this->*readers[i].read_)(readers[i].values_, false);
+                    b.set_valid(row);
+                }
+            }
+        }
+
+        return row;
+    }
+
     template<typename T>
     void operator()(T* data, typename boost::enable_if< boost::is_signed<T> >::type* = 0)
     {
@@ -106,11 +166,33 @@ public:
         data->assign(txt, size);
     }
 
-    void operator()(std::ostream* data)
+    void operator()(string_ref* data)
     {
         char const *txt = (char const *)sqlite3_column_text(st_, fetch_col_);
         int size = sqlite3_column_bytes(st_, fetch_col_);
-        data->write(txt,size);
+        *data = string_ref(txt, size);
+    }
+
+    // Whole value is already in memory of sqlite, use edba::sqlite3::blob_stream to read it in chunks
+    void operator()(std::ostream* data)
+    {
+        char const *bytes = (char const *)sqlite3_column_blob(st_, fetch_col_);
+        int size = sqlite3_column_bytes(st_, fetch_col_);
+        data->write(bytes, size);
+    }
+
+    void operator()(std::vector<unsigned char>* data)
+    {
+        unsigned char const *bytes = (unsigned char const *)sqlite3_column_blob(st_, fetch_col_);
+        int size = sqlite3_column_bytes(st_, fetch_col_);
+        data->assign(bytes, bytes + size);
+    }
+
+    void operator()(blob_ref* data)
+    {
+        void const *bytes = sqlite3_column_blob(st_, fetch_col_);
+        int size = sqlite3_column_bytes(st_, fetch_col_);
+        *data = blob_ref(bytes, size);
     }
 
     void operator()(std::tm *data)
@@ -118,6 +200,13 @@ public:
         *data = parse_time((char const *)(sqlite3_column_text(st_, fetch_col_)));
     }
 
+    void operator()(timestamp *data)
+    {
+        char const *txt = (char const *)sqlite3_column_text(st_, fetch_col_);
+        int size = sqlite3_column_bytes(st_, fetch_col_);
+        *data = parse_timestamp(string_ref(txt, txt + size));
+    }
+
     virtual bool is_null(int col)
     {
         if(col < 0 || col >= cols_)
@@ -166,19 +255,46 @@ public:
         return name;
     }
 private:
+    // Append value of column fetch_col_ to vector of type std::vector<T>, or default value if \a null is true
+    template<typename T>
+    void read_into(void* values, bool null)
+    {
+        std::vector<T>& v = *static_cast<std::vector<T>*>(values);
+        v.push_back(T());
+        if(!null)
+            (*this)(&v.back());
+    }
+
+    struct batch_reader
+    {
+        void (result::*read_)(void*, bool);
+        void* values_;
+    };
+
+    struct resolve_reader : boost::static_visitor<batch_reader>
+    {
+        template<typename T>
+        batch_reader operator()(std::vector<T>* v) const
+        {
+            batch_reader r = { &result::read_into<T>, v };
+            return r;
+        }
+    };
+
     sqlite3_stmt *st_;
-    sqlite3 *conn_;
+    ::sqlite3 *conn_;
 
     typedef std::map<string_ref, int, string_ref_iless> column_names_map;
     column_names_map column_names_;
     int cols_;
     int fetch_col_;
+    bool done_;
 };
 
 class statement : public backend::statement, public boost::static_visitor<>
 {
 public:
-    statement(const string_ref& query, sqlite3* conn, session_stat* stat) :
+    statement(const string_ref& query, ::sqlite3* conn, session_stat* stat) :
         backend::statement(stat),
         st_(0),
         conn_(conn),
@@ -262,21 +378,81 @@ public:
         check_bind(sqlite3_bind_text(st_, bind_col_, v.begin(), int(v.size()), SQLITE_TRANSIENT));
     }
 
+    void operator()(const borrowed_string& v)
+    {
+        // Caller keeps data alive until execution, see by_ref
+        check_bind(sqlite3_bind_text(st_, bind_col_, v.begin(), int(v.size()), SQLITE_STATIC));
+    }
+
     void operator()(const std::tm& v)
     {
         std::string tmp = format_time(v);
         check_bind(sqlite3_bind_text(st_, bind_col_, tmp.c_str(), int(tmp.size()), SQLITE_TRANSIENT));
     }
 
-    void operator()(std::istream* v)
+    void operator()(const timestamp& v)
     {
-        // TODO Fix me
-        std::ostringstream ss;
-        ss << v->rdbuf();
-        std::string tmp = ss.str();
+        std::string tmp = format_timestamp(v);
         check_bind(sqlite3_bind_text(st_, bind_col_, tmp.c_str(), int(tmp.size()), SQLITE_TRANSIENT));
     }
 
+    void operator()(const blob_ref& v)
+    {
+        // Null pointer would be bound as NULL
+        if (v.empty())
+            check_bind(sqlite3_bind_zeroblob(st_, bind_col_, 0));
+        else
+            check_bind(sqlite3_bind_blob(st_, bind_col_, v.data(), int(v.size()), SQLITE_TRANSIENT));
+    }
+
+    void operator()(const borrowed_blob& v)
+    {
+        if (v.empty())
+            check_bind(sqlite3_bind_zeroblob(st_, bind_col_, 0));
+        else // Caller keeps data alive until execution, see by_ref
+            check_bind(sqlite3_bind_blob(st_, bind_col_, v.data(), int(v.size()), SQLITE_STATIC));
+    }
+
+    void operator()(std::istream* v)
+    {
+        // Generic stream is still materialized: sqlite binds value only as a whole and incremental blob I/O
+        // works only on stored rows. Stream is read directly into memory handed over to sqlite, avoiding
+        // intermediate copies. For values that don`t fit in memory bind zeroblob(N) and write with
+        // edba::sqlite3::blob_stream
+        std::size_t capacity = 64 * 1024;
+        std::size_t size = 0;
+        char* data = static_cast<char*>(malloc(capacity));
+        if (!data)
+            throw std::bad_alloc();
+
+        for (;;)
+        {
+            v->read(data + size, std::streamsize(capacity - size));
+            size += std::size_t(v->gcount());
+            if (size < capacity)
+                break;
+
+            char* grown = static_cast<char*>(realloc(data, capacity * 2));
+            if (!grown)
+            {
+                free(data);
+                throw std::bad_alloc();
+            }
+
+            data = grown;
+            capacity *= 2;
+        }
+
+        if (size > std::size_t((std::numeric_limits<int>::max)()))
+        {
+            free(data);
+            throw edba_error("sqlite3:blob is too big");
+        }
+
+        // sqlite calls free even if binding fails
+        check_bind(sqlite3_bind_blob(st_, bind_col_, data, int(size), free));
+    }
+
     // backend::statement implementation
 
     virtual const std::string& patched_query() const
@@ -326,127 +502,1057 @@ private:
         }
     }
     sqlite3_stmt *st_;
-    sqlite3 *conn_;
+    ::sqlite3 *conn_;
     std::string orig_sql_;
     bool reset_;
     int bind_col_;
 };
 
-class connection : public backend::connection {
+class blob : public edba::sqlite3::blob_iface
+{
 public:
-    connection(const conn_info& ci, session_monitor* si) : backend::connection(ci, si), conn_(0)
+    blob(const backend::connection_ptr& owner, ::sqlite3* conn, sqlite3_blob* b)
+      : owner_(owner), conn_(conn), blob_(b)
     {
-        std::string dbname = ci.get_copy("db");
-        if(dbname.empty()) {
-            throw edba_error("sqlite3:database file (db propery) not specified");
-        }
+    }
 
-        string_ref mode = ci.get("mode", "create");
+    ~blob()
+    {
+        sqlite3_blob_close(blob_);
+    }
 
-        int flags = 0;
-        if(boost::algorithm::iequals(mode, "create"))
-            flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
-        else if(boost::iequals(mode, "readonly"))
-            flags = SQLITE_OPEN_READONLY;
-        else if(boost::iequals(mode, "readwrite"))
-            flags = SQLITE_OPEN_READWRITE;
-        else {
-            throw edba_error("sqlite3:invalid mode propery, expected "
-                " 'create' (default), 'readwrite' or 'readonly' values");
-        }
+    virtual std::size_t size()
+    {
+        return std::size_t(sqlite3_blob_bytes(blob_));
+    }
 
-        std::string vfs = ci.get_copy("vfs");
-        char const *cvfs = vfs.empty() ? (char const *)(0) : vfs.c_str();
+    virtual void read(std::size_t offset, void* buf, std::size_t n)
+    {
+        check_range(offset, n);
+        check(sqlite3_blob_read(blob_, buf, int(n), int(offset)));
+    }
 
-        if(sqlite3_open_v2(dbname.c_str(),&conn_,flags,cvfs) != SQLITE_OK) {
-            if(conn_ == 0) {
-                throw edba_error("sqlite3:failed to create db object");
-            }
-            std::string error_message;
-            try { error_message = sqlite3_errmsg(conn_); }catch(...){}
-            sqlite3_close(conn_);
-            conn_ = 0;
-            throw edba_error("sqlite3:Failed to open connection:" + error_message);
-        }
+    virtual void write(std::size_t offset, const void* buf, std::size_t n)
+    {
+        check_range(offset, n);
+        check(sqlite3_blob_write(blob_, buf, int(n), int(offset)));
     }
-    virtual ~connection()
+
+    virtual void reopen(long long rowid)
     {
-        sqlite3_close(conn_);
+        check(sqlite3_blob_reopen(blob_, rowid));
     }
-    virtual void begin_impl()
+
+private:
+    void check_range(std::size_t offset, std::size_t n)
     {
-        fast_exec("begin");
+        if (offset > size() || n > size() - offset)
+            throw edba_error("sqlite3:blob access out of range");
     }
-    virtual void commit_impl()
+
+    void check(int rc)
     {
-        fast_exec("commit");
+        if (rc != SQLITE_OK)
+            throw edba_error(std::string("sqlite3:") + sqlite3_errmsg(conn_));
     }
-    virtual void rollback_impl()
+
+    backend::connection_ptr owner_;
+    ::sqlite3* conn_;
+    sqlite3_blob* blob_;
+};
+
+// Converts arguments and result of user defined function
+class function_context : public edba::sqlite3::function_context, public boost::static_visitor<>
+{
+public:
+    function_context(sqlite3_context* ctx, int argc, sqlite3_value** argv)
+      : ctx_(ctx), argc_(argc), argv_(argv), arg_(0)
     {
-        fast_exec("rollback");
     }
-    virtual backend::statement_ptr prepare_statement_impl(const string_ref& q)
+
+    virtual int args()
     {
-        return backend::statement_ptr(new statement(q, conn_, &stat_));
+        return argc_;
     }
-    virtual backend::statement_ptr create_statement_impl(const string_ref& q)
+
+    virtual bool is_null(int arg)
     {
-        return prepare_statement_impl(q);
+        return sqlite3_value_type(value(arg)) == SQLITE_NULL;
     }
-    virtual void exec_batch_impl(const string_ref& q)
+
+    template<typename T>
+    void operator()(T* data, typename boost::enable_if< boost::is_signed<T> >::type* = 0)
     {
-        if (expand_conditionals_)
-            fast_exec(q.begin());
-        else
-        {
-            // copy whole string to make it null terminated :(
-            std::string tmp(q.begin(), q.end());
-            fast_exec(tmp.c_str());
-        }
+        sqlite3_int64 rv = sqlite3_value_int64(argv_[arg_]);
+        T tmp = static_cast<T>(rv);
+        if (static_cast<sqlite3_int64>(tmp) != rv)
+            throw bad_value_cast();
+
+        *data = tmp;
     }
-    virtual std::string escape(const string_ref& str)
+
+    template<typename T>
+    void operator()(T* data, typename boost::enable_if< boost::is_unsigned<T> >::type* = 0)
     {
-        std::string result;
-        result.reserve(str.size());
+        sqlite3_int64 rv = sqlite3_value_int64(argv_[arg_]);
+        if (rv < 0)
+            throw bad_value_cast();
+        unsigned long long urv = static_cast<unsigned long long>(rv);
+        T tmp = static_cast<T>(urv);
+        if(static_cast<unsigned long long>(tmp)!=urv)
+            throw bad_value_cast();
 
-        BOOST_FOREACH(char c, str)
-        {
-            if(c=='\'')
-                result.append("''");
-            else
-                result.push_back(c);
-        }
+        *data = tmp;
+    }
 
-        return result;
+    template<typename T>
+    void operator()(T* data, typename boost::enable_if< boost::is_floating_point<T> >::type* = 0)
+    {
+        *data = static_cast<T>(sqlite3_value_double(argv_[arg_]));
     }
 
-    virtual const std::string& backend()
+    void operator()(std::string* data)
     {
-        return g_backend_name;
+        *data = to_string(text());
     }
-    virtual const std::string& engine()
+
+    void operator()(string_ref* data)
     {
-        return g_engine_name;
+        *data = text();
     }
-    virtual void version(int& major, int& minor)
+
+    void operator()(std::ostream* data)
     {
-        major = g_ver_major;
-        minor = g_ver_minor;
+        blob_ref b = bytes();
+        data->write(b.data(), b.size());
     }
-    virtual const std::string& description()
+
+    void operator()(std::vector<unsigned char>* data)
     {
-        return g_description;
+        blob_ref b = bytes();
+        data->assign(b.begin(), b.end());
+    }
+
+    void operator()(blob_ref* data)
+    {
+        *data = bytes();
+    }
+
+    void operator()(std::tm *data)
+    {
+        int us;
+        *data = parse_time(text(), us);
+    }
+
+    void operator()(timestamp *data)
+    {
+        *data = parse_timestamp(text());
+    }
+
+    // Result
+
+    void operator()(null_type)
+    {
+        sqlite3_result_null(ctx_);
+    }
+
+    template<typename T>
+    void operator()(T v, typename boost::enable_if< boost::is_integral<T> >::type* = 0)
+    {
+        sqlite3_result_int64(ctx_, static_cast<sqlite3_int64>(v));
+    }
+
+    template<typename T>
+    void operator()(T v, typename boost::enable_if< boost::is_floating_point<T> >::type* = 0)
+    {
+        sqlite3_result_double(ctx_, static_cast<double>(v));
+    }
+
+    void operator()(const string_ref& v)
+    {
+        sqlite3_result_text(ctx_, v.empty() ? "" : v.begin(), int(v.size()), SQLITE_TRANSIENT);
+    }
+
+    void operator()(const std::tm& v)
+    {
+        (*this)(string_ref(format_time(v)));
+    }
+
+    void operator()(const timestamp& v)
+    {
+        (*this)(string_ref(format_timestamp(v)));
+    }
+
+    void operator()(const blob_ref& v)
+    {
+        sqlite3_result_blob(ctx_, v.empty() ? "" : v.data(), int(v.size()), SQLITE_TRANSIENT);
+    }
+
+    void operator()(std::istream* v)
+    {
+        std::ostringstream ss;
+        ss << v->rdbuf();
+        std::string tmp = ss.str();
+        sqlite3_result_blob(ctx_, tmp.data(), int(tmp.size()), SQLITE_TRANSIENT);
+    }
+
+    // Report exception thrown by user function as query error
+    void error(const char* msg)
+    {
+        sqlite3_result_error(ctx_, msg, -1);
+    }
+
+protected:
+    virtual bool fetch_impl(int arg, const fetch_types_variant& v)
+    {
+        if(is_null(arg))
+            return false;
+
+        arg_ = arg;
+        v.apply_visitor(*this);
+        return true;
+    }
+
+    virtual void result_impl(const bind_types_variant& v)
+    {
+        v.apply_visitor(*this);
     }
 
 private:
-    void fast_exec(char const *query)
+    sqlite3_value* value(int arg)
     {
-        if(sqlite3_exec(conn_,query,0,0,0)!=SQLITE_OK) {
-            throw edba_error(std::string("sqlite3:") + sqlite3_errmsg(conn_));
+        if(arg < 0 || arg >= argc_)
+            throw invalid_column(arg);
+
+        return argv_[arg];
+    }
+
+    string_ref text()
+    {
+        char const *txt = (char const *)sqlite3_value_text(argv_[arg_]);
+        return string_ref(txt, sqlite3_value_bytes(argv_[arg_]));
+    }
+
+    blob_ref bytes()
+    {
+        void const *data = sqlite3_value_blob(argv_[arg_]);
+        return blob_ref(data, sqlite3_value_bytes(argv_[arg_]));
+    }
+
+    sqlite3_context* ctx_;
+    int argc_;
+    sqlite3_value** argv_;
+    int arg_;
+};
+
+// Callbacks of user defined functions, exceptions must not propagate into sqlite
+
+void call_scalar(sqlite3_context* ctx, int argc, sqlite3_value** argv)
+{
+    function_context fc(ctx, argc, argv);
+    try
+    {
+        (*static_cast<edba::sqlite3::scalar_function*>(sqlite3_user_data(ctx)))(fc);
+    }
+    catch(std::exception& e)
+    {
+        fc.error(e.what());
+    }
+    catch(...)
+    {
+        fc.error("unknown error");
+    }
+}
+
+void destroy_scalar(void* f)
+{
+    delete static_cast<edba::sqlite3::scalar_function*>(f);
+}
+
+// Aggregate context holds pointer to state created on the first step. Return null if there were no steps
+// and \a create is false
+edba::sqlite3::aggregate_iface* aggregate_state(sqlite3_context* ctx, bool create)
+{
+    edba::sqlite3::aggregate_iface** state = static_cast<edba::sqlite3::aggregate_iface**>(
+        sqlite3_aggregate_context(ctx, create ? int(sizeof(edba::sqlite3::aggregate_iface*)) : 0));
+
+    if(!state)
+    {
+        if(create)
+            throw std::bad_alloc();
+        return 0;
+    }
+
+    if(!*state)
+        *state = (*static_cast<edba::sqlite3::aggregate_factory*>(sqlite3_user_data(ctx)))();
+
+    return *state;
+}
+
+void call_step(sqlite3_context* ctx, int argc, sqlite3_value** argv)
+{
+    function_context fc(ctx, argc, argv);
+    try
+    {
+        aggregate_state(ctx, true)->step(fc);
+    }
+    catch(std::exception& e)
+    {
+        fc.error(e.what());
+    }
+    catch(...)
+    {
+        fc.error("unknown error");
+    }
+}
+
+void call_inverse(sqlite3_context* ctx, int argc, sqlite3_value** argv)
+{
+    function_context fc(ctx, argc, argv);
+    try
+    {
+        aggregate_state(ctx, true)->inverse(fc);
+    }
+    catch(std::exception& e)
+    {
+        fc.error(e.what());
+    }
+    catch(...)
+    {
+        fc.error("unknown error");
+    }
+}
+
+void call_value(sqlite3_context* ctx)
+{
+    function_context fc(ctx, 0, 0);
+    try
+    {
+        aggregate_state(ctx, true)->value(fc);
+    }
+    catch(std::exception& e)
+    {
+        fc.error(e.what());
+    }
+    catch(...)
+    {
+        fc.error("unknown error");
+    }
+}
+
+void call_final(sqlite3_context* ctx)
+{
+    function_context fc(ctx, 0, 0);
+    try
+    {
+        // Group without rows gets result from fresh state
+        edba::sqlite3::aggregate_iface* state = aggregate_state(ctx, false);
+        boost::scoped_ptr<edba::sqlite3::aggregate_iface> owner(state ? state : (*static_cast<edba::sqlite3::aggregate_factory*>(sqlite3_user_data(ctx)))());
+        owner->value(fc);
+    }
+    catch(std::exception& e)
+    {
+        fc.error(e.what());
+    }
+    catch(...)
+    {
+        fc.error("unknown error");
+    }
+}
+
+void destroy_aggregate(void* f)
+{
+    delete static_cast<edba::sqlite3::aggregate_factory*>(f);
+}
+
+// Virtual table module, sqlite3_vtab and sqlite3_vtab_cursor must be the first members of derived structures
+
+struct module_vtab : sqlite3_vtab
+{
+    edba::sqlite3::vtab_ptr table_;
+};
+
+// xEof can`t report errors, so eof() is evaluated after filter() and next() and cached in eof_
+struct module_cursor : sqlite3_vtab_cursor
+{
+    module_cursor() : eof_(true) {}
+
+    boost::scoped_ptr<edba::sqlite3::vtab_cursor_iface> cursor_;
+    bool eof_;
+};
+
+int set_vtab_error(sqlite3_vtab* vtab, const char* msg)
+{
+    sqlite3_free(vtab->zErrMsg);
+    vtab->zErrMsg = sqlite3_mprintf("%s", msg);
+    return SQLITE_ERROR;
+}
+
+int vtab_connect(::sqlite3* db, void* aux, int, const char* const*, sqlite3_vtab** out, char** err)
+{
+    try
+    {
+        const edba::sqlite3::vtab_ptr& table = *static_cast<edba::sqlite3::vtab_ptr*>(aux);
+        int rc = sqlite3_declare_vtab(db, table->schema().c_str());
+        if(rc != SQLITE_OK)
+            return rc;
+
+        module_vtab* vtab = new module_vtab();
+        vtab->table_ = table;
+        *out = vtab;
+        return SQLITE_OK;
+    }
+    catch(std::exception& e)
+    {
+        *err = sqlite3_mprintf("%s", e.what());
+        return SQLITE_ERROR;
+    }
+    catch(...)
+    {
+        *err = sqlite3_mprintf("%s", "unknown error");
+        return SQLITE_ERROR;
+    }
+}
+
+int vtab_disconnect(sqlite3_vtab* vtab)
+{
+    sqlite3_free(vtab->zErrMsg);
+    delete static_cast<module_vtab*>(vtab);
+    return SQLITE_OK;
+}
+
+int vtab_best_index(sqlite3_vtab* vtab, sqlite3_index_info* info)
+{
+    try
+    {
+        edba::sqlite3::index_info ii;
+        ii.constraints.resize(info->nConstraint);
+        for(int i = 0; i < info->nConstraint; ++i)
+        {
+            edba::sqlite3::index_constraint& c = ii.constraints[i];
+            c.column = info->aConstraint[i].iColumn;
+            c.op = info->aConstraint[i].op;
+            c.usable = info->aConstraint[i].usable != 0;
+            c.argv_index = 0;
+            c.omit = false;
+        }
+
+        static_cast<module_vtab*>(vtab)->table_->best_index(ii);
+
+        for(int i = 0; i < info->nConstraint; ++i)
+        {
+            info->aConstraintUsage[i].argvIndex = ii.constraints[i].argv_index;
+            info->aConstraintUsage[i].omit = ii.constraints[i].omit;
+        }
+
+        info->idxNum = ii.idx_num;
+        info->estimatedCost = ii.estimated_cost;
+#if SQLITE_VERSION_NUMBER >= 3008002
+        info->estimatedRows = ii.estimated_rows;
+#endif
+        return SQLITE_OK;
+    }
+    catch(std::exception& e)
+    {
+        return set_vtab_error(vtab, e.what());
+    }
+    catch(...)
+    {
+        return set_vtab_error(vtab, "unknown error");
+    }
+}
+
+int vtab_open(sqlite3_vtab* vtab, sqlite3_vtab_cursor** out)
+{
+    try
+    {
+        module_cursor* cur = new module_cursor();
+        cur->cursor_.reset(static_cast<module_vtab*>(vtab)->table_->open());
+        *out = cur;
+        return SQLITE_OK;
+    }
+    catch(std::exception& e)
+    {
+        return set_vtab_error(vtab, e.what());
+    }
+    catch(...)
+    {
+        return set_vtab_error(vtab, "unknown error");
+    }
+}
+
+int vtab_close(sqlite3_vtab_cursor* cur)
+{
+    delete static_cast<module_cursor*>(cur);
+    return SQLITE_OK;
+}
+
+int vtab_filter(sqlite3_vtab_cursor* cur, int idx_num, const char*, int argc, sqlite3_value** argv)
+{
+    try
+    {
+        module_cursor* mc = static_cast<module_cursor*>(cur);
+        function_context args(0, argc, argv);
+        mc->eof_ = true;
+        mc->cursor_->filter(idx_num, args);
+        mc->eof_ = mc->cursor_->eof();
+        return SQLITE_OK;
+    }
+    catch(std::exception& e)
+    {
+        return set_vtab_error(cur->pVtab, e.what());
+    }
+    catch(...)
+    {
+        return set_vtab_error(cur->pVtab, "unknown error");
+    }
+}
+
+int vtab_next(sqlite3_vtab_cursor* cur)
+{
+    try
+    {
+        module_cursor* mc = static_cast<module_cursor*>(cur);
+        mc->eof_ = true;
+        mc->cursor_->next();
+        mc->eof_ = mc->cursor_->eof();
+        return SQLITE_OK;
+    }
+    catch(std::exception& e)
+    {
+        return set_vtab_error(cur->pVtab, e.what());
+    }
+    catch(...)
+    {
+        return set_vtab_error(cur->pVtab, "unknown error");
+    }
+}
+
+int vtab_eof(sqlite3_vtab_cursor* cur)
+{
+    return static_cast<module_cursor*>(cur)->eof_ ? 1 : 0;
+}
+
+int vtab_column(sqlite3_vtab_cursor* cur, sqlite3_context* ctx, int col)
+{
+    function_context fc(ctx, 0, 0);
+    try
+    {
+        static_cast<module_cursor*>(cur)->cursor_->column(col, fc);
+        return SQLITE_OK;
+    }
+    catch(std::exception& e)
+    {
+        fc.error(e.what());
+        return SQLITE_ERROR;
+    }
+    catch(...)
+    {
+        fc.error("unknown error");
+        return SQLITE_ERROR;
+    }
+}
+
+int vtab_rowid(sqlite3_vtab_cursor* cur, sqlite3_int64* rowid)
+{
+    try
+    {
+        *rowid = static_cast<module_cursor*>(cur)->cursor_->rowid();
+        return SQLITE_OK;
+    }
+    catch(std::exception& e)
+    {
+        return set_vtab_error(cur->pVtab, e.what());
+    }
+    catch(...)
+    {
+        return set_vtab_error(cur->pVtab, "unknown error");
+    }
+}
+
+void destroy_vtab(void* table)
+{
+    delete static_cast<edba::sqlite3::vtab_ptr*>(table);
+}
+
+// Eponymous-only module, xCreate is not set so table exists without CREATE VIRTUAL TABLE.
+// Fields are assigned by name, the set of fields depends on sqlite version
+sqlite3_module make_vtab_module()
+{
+    sqlite3_module m = sqlite3_module();
+    m.xConnect = &vtab_connect;
+    m.xBestIndex = &vtab_best_index;
+    m.xDisconnect = &vtab_disconnect;
+    m.xOpen = &vtab_open;
+    m.xClose = &vtab_close;
+    m.xFilter = &vtab_filter;
+    m.xNext = &vtab_next;
+    m.xEof = &vtab_eof;
+    m.xColumn = &vtab_column;
+    m.xRowid = &vtab_rowid;
+    return m;
+}
+
+sqlite3_module g_vtab_module = make_vtab_module();
+
+class backup : public edba::sqlite3::backup_iface
+{
+public:
+    // Destination is either another connection kept alive by \a dest_conn or database opened for backup only
+    backup(
+        const backend::connection_ptr& source
+      , const backend::connection_ptr& dest_conn
+      , const boost::shared_ptr< ::sqlite3>& dest_file
+      , ::sqlite3* dest
+      , sqlite3_backup* b
+      )
+      : source_(source), dest_conn_(dest_conn), dest_file_(dest_file), dest_(dest), backup_(b)
+    {
+    }
+
+    ~backup()
+    {
+        sqlite3_backup_finish(backup_);
+    }
+
+    virtual bool step(int pages)
+    {
+        int rc = sqlite3_backup_step(backup_, pages);
+        switch(rc)
+        {
+        case SQLITE_DONE:
+            return true;
+        case SQLITE_OK:
+            return false;
+        case SQLITE_BUSY:
+        case SQLITE_LOCKED:
+            // Give other connection a chance to release the lock
+            sqlite3_sleep(10);
+            return false;
+        default:
+            throw edba_error(std::string("sqlite3:backup failed:") + sqlite3_errmsg(dest_));
+        }
+    }
+
+    virtual int remaining()
+    {
+        return sqlite3_backup_remaining(backup_);
+    }
+
+    virtual int page_count()
+    {
+        return sqlite3_backup_pagecount(backup_);
+    }
+
+private:
+    backend::connection_ptr source_;
+    backend::connection_ptr dest_conn_;
+    boost::shared_ptr< ::sqlite3> dest_file_;
+    ::sqlite3* dest_;
+    sqlite3_backup* backup_;
+};
+
+class connection : public backend::connection, public edba::sqlite3::extension_iface {
+public:
+    connection(const conn_info& ci, session_monitor* si) : backend::connection(ci, si), conn_(0), throughput_(false), uri_(false)
+    {
+        std::string dbname = ci.get_copy("db");
+
+        // Named in-memory database shared by all connections of the process, lives while any of them is open
+        string_ref memory = ci.get("memory");
+        if(!memory.empty()) {
+            if(!dbname.empty()) {
+                throw edba_error("sqlite3:db and memory properties can`t be used together");
+            }
+            BOOST_FOREACH(char c, memory) {
+                bool alnum = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+                if(!alnum && c != '_' && c != '-' && c != '.') {
+                    throw edba_error("sqlite3:memory database name may contain only letters, digits, '_', '-' and '.'");
+                }
+            }
+            dbname = "file:" + to_string(memory) + "?mode=memory&cache=shared";
+        }
+
+        if(dbname.empty()) {
+            throw edba_error("sqlite3:database file (db propery) not specified");
+        }
+
+        string_ref mode = ci.get("mode", "create");
+
+        // db is treated as URI, for example file:snapshot.db?immutable=1, only on request,
+        // otherwise plain file names that start with file: would change their meaning
+        uri_ = on_off_option("uri");
+        int flags = SQLITE_OPEN_URI;
+        if(memory.empty())
+            dbname = file_name(dbname);
+        if(boost::algorithm::iequals(mode, "create"))
+            flags |= SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+        else if(boost::iequals(mode, "readonly"))
+            flags |= SQLITE_OPEN_READONLY;
+        else if(boost::iequals(mode, "readwrite"))
+            flags |= SQLITE_OPEN_READWRITE;
+        else {
+            throw edba_error("sqlite3:invalid mode propery, expected "
+                " 'create' (default), 'readwrite' or 'readonly' values");
+        }
+
+        string_ref profile = ci.get("profile");
+        if(boost::algorithm::iequals(profile, "throughput"))
+            throughput_ = true;
+        else if(!profile.empty()) {
+            throw edba_error("sqlite3:invalid profile property, expected 'throughput'");
+        }
+
+        if(on_off_option("nomutex"))
+            flags |= SQLITE_OPEN_NOMUTEX;
+
+        if(!option("shared_cache").empty())
+            flags |= on_off_option("shared_cache") ? SQLITE_OPEN_SHAREDCACHE : SQLITE_OPEN_PRIVATECACHE;
+
+        std::string vfs = ci.get_copy("vfs");
+        char const *cvfs = vfs.empty() ? (char const *)(0) : vfs.c_str();
+
+        if(sqlite3_open_v2(dbname.c_str(),&conn_,flags,cvfs) != SQLITE_OK) {
+            if(conn_ == 0) {
+                throw edba_error("sqlite3:failed to create db object");
+            }
+            std::string error_message;
+            try { error_message = sqlite3_errmsg(conn_); }catch(...){}
+            sqlite3_close(conn_);
+            conn_ = 0;
+            throw edba_error("sqlite3:Failed to open connection:" + error_message);
+        }
+
+        try
+        {
+            tune();
+        }
+        catch(...)
+        {
+            sqlite3_close(conn_);
+            conn_ = 0;
+            throw;
+        }
+    }
+    virtual ~connection()
+    {
+        sqlite3_close(conn_);
+    }
+    virtual void begin_impl()
+    {
+        fast_exec("begin");
+    }
+    virtual void commit_impl()
+    {
+        fast_exec("commit");
+    }
+    virtual void rollback_impl()
+    {
+        fast_exec("rollback");
+    }
+    virtual backend::statement_ptr prepare_statement_impl(const string_ref& q)
+    {
+        return backend::statement_ptr(new statement(q, conn_, &stat_));
+    }
+    virtual backend::statement_ptr create_statement_impl(const string_ref& q)
+    {
+        return prepare_statement_impl(q);
+    }
+    virtual void exec_batch_impl(const string_ref& q)
+    {
+        if (expand_conditionals_)
+            fast_exec(q.begin());
+        else
+        {
+            // copy whole string to make it null terminated :(
+            std::string tmp(q.begin(), q.end());
+            fast_exec(tmp.c_str());
+        }
+    }
+    virtual std::string escape(const string_ref& str)
+    {
+        std::string result;
+        result.reserve(str.size());
+
+        BOOST_FOREACH(char c, str)
+        {
+            if(c=='\'')
+                result.append("''");
+            else
+                result.push_back(c);
+        }
+
+        return result;
+    }
+
+    virtual const std::string& backend()
+    {
+        return g_backend_name;
+    }
+    virtual const std::string& engine()
+    {
+        return g_engine_name;
+    }
+    virtual void version(int& major, int& minor)
+    {
+        major = g_ver_major;
+        minor = g_ver_minor;
+    }
+    virtual const std::string& description()
+    {
+        return g_description;
+    }
+
+    virtual void* get_extension(const string_ref& name)
+    {
+        if (boost::algorithm::equals(name, edba::sqlite3::extension::extension_name()))
+            return static_cast<edba::sqlite3::extension_iface*>(this);
+
+        return 0;
+    }
+
+    // edba::sqlite3::extension_iface implementation
+
+    virtual edba::sqlite3::blob_ptr open_blob(const backend::connection_ptr& owner, const string_ref& table, const string_ref& column, long long rowid, bool writable)
+    {
+        std::string t(table.begin(), table.end());
+        std::string c(column.begin(), column.end());
+
+        sqlite3_blob* b = 0;
+        if (sqlite3_blob_open(conn_, "main", t.c_str(), c.c_str(), rowid, writable ? 1 : 0, &b) != SQLITE_OK)
+        {
+            std::string error_message = sqlite3_errmsg(conn_);
+            sqlite3_blob_close(b);
+            throw edba_error("sqlite3:" + error_message);
+        }
+
+        return edba::sqlite3::blob_ptr(new blob(owner, conn_, b));
+    }
+
+    virtual edba::sqlite3::backup_ptr start_backup(
+        const backend::connection_ptr& owner
+      , edba::sqlite3::extension_iface& destination
+      , const backend::connection_ptr& destination_owner
+      )
+    {
+        connection* dest = dynamic_cast<connection*>(&destination);
+        if(!dest)
+            throw edba_error("sqlite3:backup destination is not sqlite3 connection");
+
+        return start_backup(owner, destination_owner, boost::shared_ptr< ::sqlite3>(), dest->conn_);
+    }
+
+    virtual edba::sqlite3::backup_ptr start_backup(const backend::connection_ptr& owner, const string_ref& file)
+    {
+        std::string name = file_name(file);
+
+        ::sqlite3* dest = 0;
+        int rc = sqlite3_open_v2(name.c_str(), &dest, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI, 0);
+        boost::shared_ptr< ::sqlite3> holder(dest, sqlite3_close);
+        if(rc != SQLITE_OK) {
+            throw edba_error(std::string("sqlite3:Failed to open backup destination:") + (dest ? sqlite3_errmsg(dest) : "out of memory"));
+        }
+
+        return start_backup(owner, backend::connection_ptr(), holder, dest);
+    }
+
+    virtual void create_function(const string_ref& name, int nargs, const edba::sqlite3::scalar_function& f, bool deterministic)
+    {
+        std::string n(name.begin(), name.end());
+        int flags = SQLITE_UTF8 | (deterministic ? SQLITE_DETERMINISTIC : 0);
+
+        // sqlite calls destroy_scalar even if registration fails
+        int rc = sqlite3_create_function_v2(conn_, n.c_str(), nargs, flags, new edba::sqlite3::scalar_function(f)
+          , &call_scalar, 0, 0, &destroy_scalar);
+        check_create_function(rc);
+    }
+
+    virtual void create_aggregate(const string_ref& name, int nargs, const edba::sqlite3::aggregate_factory& factory)
+    {
+        std::string n(name.begin(), name.end());
+
+        int rc = sqlite3_create_function_v2(conn_, n.c_str(), nargs, SQLITE_UTF8, new edba::sqlite3::aggregate_factory(factory)
+          , 0, &call_step, &call_final, &destroy_aggregate);
+        check_create_function(rc);
+    }
+
+    virtual void create_window_function(const string_ref& name, int nargs, const edba::sqlite3::aggregate_factory& factory)
+    {
+#if SQLITE_VERSION_NUMBER >= 3025000
+        std::string n(name.begin(), name.end());
+
+        int rc = sqlite3_create_window_function(conn_, n.c_str(), nargs, SQLITE_UTF8, new edba::sqlite3::aggregate_factory(factory)
+          , &call_step, &call_final, &call_value, &call_inverse, &destroy_aggregate);
+        check_create_function(rc);
+#else
+        throw not_supported_by_backend("sqlite3:window functions require sqlite 3.25");
+#endif
+    }
+
+    virtual void create_virtual_table(const string_ref& name, const edba::sqlite3::vtab_ptr& table)
+    {
+        std::string n(name.begin(), name.end());
+
+        // sqlite calls destroy_vtab even if registration fails
+        if(sqlite3_create_module_v2(conn_, n.c_str(), &g_vtab_module, new edba::sqlite3::vtab_ptr(table), &destroy_vtab) != SQLITE_OK)
+            throw edba_error(std::string("sqlite3:failed to create virtual table:") + sqlite3_errmsg(conn_));
+    }
+
+    virtual std::vector<unsigned char> serialize()
+    {
+#if SQLITE_VERSION_NUMBER >= 3023000 && !defined(SQLITE_OMIT_DESERIALIZE)
+        sqlite3_int64 size = 0;
+        unsigned char* data = sqlite3_serialize(conn_, "main", &size, 0);
+        if(!data)
+            throw edba_error(std::string("sqlite3:serialize failed:") + sqlite3_errmsg(conn_));
+
+        std::vector<unsigned char> result(data, data + size);
+        sqlite3_free(data);
+        return result;
+#else
+        throw not_supported_by_backend("sqlite3:serialize requires sqlite 3.23 compiled with deserialize support");
+#endif
+    }
+
+    virtual void deserialize(const blob_ref& data, bool readonly)
+    {
+#if SQLITE_VERSION_NUMBER >= 3023000 && !defined(SQLITE_OMIT_DESERIALIZE)
+        // sqlite takes ownership of the buffer and may resize it as database grows
+        unsigned char* buf = static_cast<unsigned char*>(sqlite3_malloc64(data.size() ? data.size() : 1));
+        if(!buf)
+            throw std::bad_alloc();
+
+        std::copy(data.begin(), data.end(), buf);
+
+        unsigned flags = SQLITE_DESERIALIZE_FREEONCLOSE | (readonly ? SQLITE_DESERIALIZE_READONLY : SQLITE_DESERIALIZE_RESIZEABLE);
+        if(sqlite3_deserialize(conn_, "main", buf, data.size(), data.size(), flags) != SQLITE_OK)
+            throw edba_error(std::string("sqlite3:deserialize failed:") + sqlite3_errmsg(conn_));
+#else
+        throw not_supported_by_backend("sqlite3:deserialize requires sqlite 3.23 compiled with deserialize support");
+#endif
+    }
+
+private:
+    void fast_exec(char const *query)
+    {
+        if(sqlite3_exec(conn_,query,0,0,0)!=SQLITE_OK) {
+            throw edba_error(std::string("sqlite3:") + sqlite3_errmsg(conn_));
+        }
+    }
+
+    edba::sqlite3::backup_ptr start_backup(
+        const backend::connection_ptr& owner
+      , const backend::connection_ptr& dest_conn
+      , const boost::shared_ptr< ::sqlite3>& dest_file
+      , ::sqlite3* dest
+      )
+    {
+        sqlite3_backup* b = sqlite3_backup_init(dest, "main", conn_, "main");
+        if(!b)
+            throw edba_error(std::string("sqlite3:backup failed:") + sqlite3_errmsg(dest));
+
+        return edba::sqlite3::backup_ptr(new backup(owner, dest_conn, dest_file, dest, b));
+    }
+
+    void check_create_function(int rc)
+    {
+        if(rc != SQLITE_OK)
+            throw edba_error(std::string("sqlite3:failed to create function:") + sqlite3_errmsg(conn_));
+    }
+
+    // Return value of connection property, or default from selected profile
+    string_ref option(const char* key) const
+    {
+        string_ref value = info_.get(key);
+        if(!value.empty() || !throughput_)
+            return value;
+
+        for(std::size_t i = 0; i < sizeof(g_throughput_profile) / sizeof(g_throughput_profile[0]); ++i)
+            if(!strcmp(g_throughput_profile[i][0], key))
+                return g_throughput_profile[i][1];
+
+        return string_ref();
+    }
+
+    // SQLite may be built to parse URI file names regardless of open flags,
+    // so plain name that looks like URI is made relative to be taken literally
+    std::string file_name(const string_ref& name) const
+    {
+        if(!uri_ && boost::algorithm::starts_with(name, "file:"))
+            return "./" + to_string(name);
+        return to_string(name);
+    }
+
+    bool on_off_option(const char* key) const
+    {
+        string_ref value = option(key);
+        if(value.empty() || boost::algorithm::iequals(value, "off"))
+            return false;
+        if(boost::algorithm::iequals(value, "on"))
+            return true;
+
+        throw edba_error(std::string("sqlite3:") + key + " property should be either 'on' or 'off'");
+    }
+
+    // Check that property is one of allowed keywords or a number and return it, as it is pasted into PRAGMA
+    std::string pragma_value(const char* key, const char* const keywords[], bool numeric)
+    {
+        string_ref value = option(key);
+        for(const char* const* k = keywords; *k; ++k)
+            if(boost::algorithm::iequals(value, *k))
+                return to_string(value);
+
+        if(numeric)
+        {
+            try
+            {
+                long long num;
+                parse_number(value, num);
+                return to_string(value);
+            }
+            catch(bad_value_cast&)
+            {
+            }
+        }
+
+        throw edba_error(std::string("sqlite3:invalid value of ") + key + " property: " + to_string(value));
+    }
+
+    // Apply tuning properties. Page size has to be set before switching to WAL mode
+    void tune()
+    {
+        static const char* const no_keywords[] = {0};
+        static const char* const journal_modes[] = {"delete", "truncate", "persist", "memory", "wal", "off", 0};
+        static const char* const synchronous_modes[] = {"off", "normal", "full", "extra", 0};
+        static const char* const temp_stores[] = {"default", "file", "memory", 0};
+
+        static const struct {
+            const char* name;
+            const char* const* keywords;
+            bool numeric;
+        } pragmas[] = {
+            {"page_size", no_keywords, true}
+          , {"journal_mode", journal_modes, false}
+          , {"synchronous", synchronous_modes, true}
+          , {"cache_size", no_keywords, true}
+          , {"mmap_size", no_keywords, true}
+          , {"temp_store", temp_stores, true}
+          , {"busy_timeout", no_keywords, true}
+        };
+
+        for(std::size_t i = 0; i < sizeof(pragmas) / sizeof(pragmas[0]); ++i)
+        {
+            if(option(pragmas[i].name).empty())
+                continue;
+
+            std::string query = std::string("pragma ") + pragmas[i].name + "=" + pragma_value(pragmas[i].name, pragmas[i].keywords, pragmas[i].numeric);
+            fast_exec(query.c_str());
         }
     }
 
-    sqlite3 *conn_;
+    ::sqlite3 *conn_;
+    bool throughput_;
+    bool uri_;
 };
 
 }}}} // edba, backend, sqlite3, anonymous
@@ -0,0 +1,333 @@
+#include <edba/arrow.hpp>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_signed.hpp>
+#include <boost/utility/enable_if.hpp>
+
+#include <limits>
+
+namespace edba {
+
+namespace {
+
+// Arrow format string for column element type
+struct arrow_format : boost::static_visitor<const char*>
+{
+    template<typename T>
+    const char* operator()(std::vector<T>*, typename boost::enable_if< boost::is_integral<T> >::type* = 0) const
+    {
+        bool s = boost::is_signed<T>::value;
+        switch(sizeof(T))
+        {
+        case 1: return s ? "c" : "C";
+        case 2: return s ? "s" : "S";
+        case 4: return s ? "i" : "I";
+        default: return s ? "l" : "L";
+        }
+    }
+
+    const char* operator()(std::vector<float>*) const { return "f"; }
+    const char* operator()(std::vector<double>*) const { return "g"; }
+    const char* operator()(std::vector<long double>*) const { return "g"; }
+    const char* operator()(std::vector<std::string>*) const { return "u"; }
+    const char* operator()(std::vector<std::tm>*) const { return "tss:"; }
+    const char* operator()(std::vector<timestamp>*) const { return "tsu:"; }
+};
+
+// Create column vector of described type and buffer that refers to it
+struct new_column : boost::static_visitor<>
+{
+    new_column(int col, std::vector<column_buffer>& buffers, std::vector< boost::shared_ptr<void> >& storage)
+      : col_(col), buffers_(buffers), storage_(storage)
+    {}
+
+    template<typename T>
+    void operator()(std::vector<T>*) const
+    {
+        boost::shared_ptr< std::vector<T> > v(new std::vector<T>);
+        storage_.push_back(v);
+        buffers_.push_back(column_buffer(col_, *v));
+    }
+
+    int col_;
+    std::vector<column_buffer>& buffers_;
+    std::vector< boost::shared_ptr<void> >& storage_;
+};
+
+// Every schema and array, including children, owns its data and can be released independently as
+// required by C Data Interface
+
+struct schema_data
+{
+    std::string name_;
+    std::vector<ArrowSchema*> children_;
+};
+
+void release_schema(ArrowSchema* schema)
+{
+    schema_data* data = static_cast<schema_data*>(schema->private_data);
+    for (std::size_t i = 0; i < data->children_.size(); ++i)
+    {
+        ArrowSchema* child = data->children_[i];
+        if (child->release)
+            child->release(child);
+        delete child;
+    }
+
+    delete data;
+    schema->release = 0;
+}
+
+void init_schema(ArrowSchema* schema, const char* format, const std::string& name, int64_t flags)
+{
+    schema_data* data = new schema_data;
+    data->name_ = name;
+
+    schema->format = format;
+    schema->name = data->name_.c_str();
+    schema->metadata = 0;
+    schema->flags = flags;
+    schema->n_children = 0;
+    schema->children = 0;
+    schema->dictionary = 0;
+    schema->release = &release_schema;
+    schema->private_data = data;
+}
+
+struct array_data
+{
+    array_data()
+    {
+        buffers_[0] = buffers_[1] = buffers_[2] = 0;
+    }
+
+    std::vector<unsigned char> validity_;
+    boost::shared_ptr<void> values_;
+    std::vector<boost::int32_t> offsets_;
+    std::string chars_;
+    const void* buffers_[3];
+    std::vector<ArrowArray*> children_;
+};
+
+void release_array(ArrowArray* array)
+{
+    array_data* data = static_cast<array_data*>(array->private_data);
+    for (std::size_t i = 0; i < data->children_.size(); ++i)
+    {
+        ArrowArray* child = data->children_[i];
+        if (child->release)
+            child->release(child);
+        delete child;
+    }
+
+    delete data;
+    array->release = 0;
+}
+
+void init_array(ArrowArray* array, int64_t length, int64_t null_count, int64_t n_buffers)
+{
+    array_data* data = new array_data;
+
+    array->length = length;
+    array->null_count = null_count;
+    array->offset = 0;
+    array->n_buffers = n_buffers;
+    array->n_children = 0;
+    array->buffers = data->buffers_;
+    array->children = 0;
+    array->dictionary = 0;
+    array->release = &release_array;
+    array->private_data = data;
+}
+
+// Move fetched column into child array, numeric vectors are passed without copying
+class export_column : public boost::static_visitor<>
+{
+public:
+    export_column(column_buffer& buf, const boost::shared_ptr<void>& values, std::size_t rows, ArrowArray* out)
+      : buf_(buf), values_(values), rows_(rows), out_(out)
+    {}
+
+    template<typename T>
+    void operator()(std::vector<T>* v) const
+    {
+        array_data* data = init(2);
+        data->values_ = values_;
+        data->buffers_[1] = &(*v)[0];
+    }
+
+    void operator()(std::vector<long double>* v) const
+    {
+        boost::shared_ptr< std::vector<double> > converted(new std::vector<double>(v->begin(), v->end()));
+
+        array_data* data = init(2);
+        data->values_ = converted;
+        data->buffers_[1] = &(*converted)[0];
+    }
+
+    void operator()(std::vector<std::string>* v) const
+    {
+        array_data* data = init(3);
+        data->offsets_.reserve(rows_ + 1);
+        data->offsets_.push_back(0);
+
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < rows_; ++i)
+            total += (*v)[i].size();
+
+        if (total > std::size_t((std::numeric_limits<boost::int32_t>::max)()))
+            throw edba_error("edba::arrow_exporter: string column data exceeds 2GB in single batch");
+
+        data->chars_.reserve(total);
+        for (std::size_t i = 0; i < rows_; ++i)
+        {
+            data->chars_.append((*v)[i]);
+            data->offsets_.push_back(static_cast<boost::int32_t>(data->chars_.size()));
+        }
+
+        data->buffers_[1] = &data->offsets_[0];
+        data->buffers_[2] = data->chars_.data();
+    }
+
+    void operator()(std::vector<std::tm>* v) const
+    {
+        boost::shared_ptr< std::vector<int64_t> > seconds(new std::vector<int64_t>(rows_));
+        for (std::size_t i = 0; i < rows_; ++i)
+        {
+            const std::tm& t = (*v)[i];
+            (*seconds)[i] = days_from_civil(t.tm_year + 1900, t.tm_mon + 1, t.tm_mday) * 86400
+                + t.tm_hour * 3600 + t.tm_min * 60 + t.tm_sec;
+        }
+
+        array_data* data = init(2);
+        data->values_ = seconds;
+        data->buffers_[1] = &(*seconds)[0];
+    }
+
+    void operator()(std::vector<timestamp>* v) const
+    {
+        boost::shared_ptr< std::vector<int64_t> > us(new std::vector<int64_t>(rows_));
+        for (std::size_t i = 0; i < rows_; ++i)
+            (*us)[i] = (*v)[i].microseconds;
+
+        array_data* data = init(2);
+        data->values_ = us;
+        data->buffers_[1] = &(*us)[0];
+    }
+
+private:
+    array_data* init(int64_t n_buffers) const
+    {
+        init_array(out_, rows_, buf_.null_count, n_buffers);
+
+        array_data* data = static_cast<array_data*>(out_->private_data);
+        if (buf_.null_count)
+        {
+            data->validity_.swap(buf_.validity);
+            data->buffers_[0] = &data->validity_[0];
+        }
+
+        return data;
+    }
+
+    column_buffer& buf_;
+    boost::shared_ptr<void> values_;
+    std::size_t rows_;
+    ArrowArray* out_;
+};
+
+}
+
+arrow_exporter::arrow_exporter(const rowset<>& rs)
+  : rs_(rs)
+  , types_(rs.columns(), batch_types_variant(static_cast<std::vector<std::string>*>(0)))
+{
+}
+
+arrow_exporter& arrow_exporter::describe(int col, const batch_types_variant& type)
+{
+    if (col < 0 || std::size_t(col) >= types_.size())
+        throw invalid_column(col);
+
+    types_[col] = type;
+    return *this;
+}
+
+void arrow_exporter::export_schema(ArrowSchema* out)
+{
+    ArrowSchema schema;
+    init_schema(&schema, "+s", std::string(), 0);
+
+    try
+    {
+        schema_data* data = static_cast<schema_data*>(schema.private_data);
+        data->children_.reserve(types_.size());
+
+        arrow_format format;
+        for (std::size_t i = 0; i < types_.size(); ++i)
+        {
+            ArrowSchema* child = new ArrowSchema();
+            data->children_.push_back(child);
+            init_schema(child, types_[i].apply_visitor(format), rs_.column_name(int(i)), ARROW_FLAG_NULLABLE);
+        }
+
+        schema.n_children = int64_t(data->children_.size());
+        schema.children = data->children_.empty() ? 0 : &data->children_[0];
+    }
+    catch(...)
+    {
+        schema.release(&schema);
+        throw;
+    }
+
+    *out = schema;
+}
+
+bool arrow_exporter::export_batch(std::size_t n, ArrowArray* out)
+{
+    std::vector<column_buffer> buffers;
+    std::vector< boost::shared_ptr<void> > storage;
+    buffers.reserve(types_.size());
+
+    for (std::size_t i = 0; i < types_.size(); ++i)
+    {
+        new_column creator(int(i), buffers, storage);
+        types_[i].apply_visitor(creator);
+    }
+
+    std::size_t rows = rs_.fetch_batch(n, buffers);
+    if (!rows)
+        return false;
+
+    ArrowArray array;
+    init_array(&array, int64_t(rows), 0, 1);
+
+    try
+    {
+        array_data* data = static_cast<array_data*>(array.private_data);
+        data->children_.reserve(buffers.size());
+
+        for (std::size_t i = 0; i < buffers.size(); ++i)
+        {
+            ArrowArray* child = new ArrowArray();
+            data->children_.push_back(child);
+
+            export_column exporter(buffers[i], storage[i], rows, child);
+            buffers[i].values.apply_visitor(exporter);
+        }
+
+        array.n_children = int64_t(data->children_.size());
+        array.children = data->children_.empty() ? 0 : &data->children_[0];
+    }
+    catch(...)
+    {
+        array.release(&array);
+        throw;
+    }
+
+    *out = array;
+    return true;
+}
+
+}
@@ -0,0 +1,126 @@
+#ifndef EDBA_ARROW_HPP
+#define EDBA_ARROW_HPP
+
+#include <edba/rowset.hpp>
+
+#include <stdint.h>
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+// Structures of Apache Arrow C Data Interface, copied from specification
+// https://arrow.apache.org/docs/format/CDataInterface.html
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+
+struct ArrowSchema {
+    // Array type description
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowSchema*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+struct ArrowArray {
+    // Array data description
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowArray*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+}
+
+#endif // ARROW_C_DATA_INTERFACE
+
+namespace edba {
+
+///
+/// \brief Export rowset as Apache Arrow C Data Interface structures, without dependency on Arrow library.
+///
+/// Rows are read with rowset::fetch_batch and every batch is exported as struct array with one child array
+/// per column. Numeric column vectors are passed to consumer without copying. Column types are mapped as follows:
+///
+/// - integer types to int8 ... uint64 of the same size and signedness
+/// - float to float32, double and long double to float64
+/// - std::string to utf8
+/// - std::tm to timestamp with seconds unit without timezone
+/// - edba::timestamp to timestamp with microseconds unit without timezone
+///
+/// Column types are not known to edba, so columns that are not described with column() are exported as utf8.
+///
+/// \code
+/// edba::arrow_exporter exporter(sess << "select id, name, salary from employees");
+/// exporter.column<int>(0).column<double>(2);
+///
+/// ArrowSchema schema;
+/// exporter.export_schema(&schema);
+///
+/// ArrowArray batch;
+/// while(exporter.export_batch(65536, &batch))
+///     consume(&schema, &batch); // consumer calls batch.release
+///
+/// schema.release(&schema);
+/// \endcode
+///
+class EDBA_API arrow_exporter
+{
+public:
+    ///
+    /// Export all columns of rowset \a rs. Rowset shouldn`t be iterated by user.
+    ///
+    explicit arrow_exporter(const rowset<>& rs);
+
+    ///
+    /// Export column \a col (starting from 0) as Arrow type corresponding to \a T. \a T should be
+    /// element type supported by column_buffer. Throws invalid_column if \a col is invalid.
+    ///
+    template<typename T>
+    arrow_exporter& column(int col)
+    {
+        // Variant holding null pointer only identifies element type
+        return describe(col, batch_types_variant(static_cast<std::vector<T>*>(0)));
+    }
+
+    ///
+    /// Fill \a out with schema of exported batches. Caller must call release callback of \a out.
+    ///
+    void export_schema(ArrowSchema* out);
+
+    ///
+    /// Fetch at most \a n rows and export them into \a out. Return false and leave \a out untouched
+    /// if no rows remain. Caller must call release callback of \a out.
+    ///
+    bool export_batch(std::size_t n, ArrowArray* out);
+
+private:
+    arrow_exporter& describe(int col, const batch_types_variant& type);
+
+    rowset<> rs_;
+    std::vector<batch_types_variant> types_;
+};
+
+}
+
+#endif // EDBA_ARROW_HPP
@@ -0,0 +1,165 @@
+#ifndef EDBA_ASYNC_RESULT_HPP
+#define EDBA_ASYNC_RESULT_HPP
+
+#include <edba/rowset.hpp>
+
+#include <boost/shared_ptr.hpp>
+
+namespace edba {
+
+/// \cond INTERNAL
+namespace detail {
+    /// Keep connection and statement alive while asynchronous operation is in progress.
+    /// If the last handle is destroyed before result was taken, destructor waits for completion and
+    /// discards result, otherwise backend could access already destroyed connection.
+    struct async_operation_state
+    {
+        async_operation_state(const backend::connection_ptr& conn, const backend::statement_ptr& stmt, bool query)
+          : conn_(conn)
+          , stmt_(stmt)
+          , query_(query)
+          , completed_(false)
+          , taken_(false)
+        {
+        }
+
+        ~async_operation_state()
+        {
+            if (taken_)
+                return;
+
+            try
+            {
+                if (query_)
+                    stmt_->async_query_result();
+                else
+                    stmt_->async_exec_result();
+            }
+            catch(...)
+            {
+            }
+        }
+
+        backend::connection_ptr conn_;
+        backend::statement_ptr stmt_;
+        bool query_;
+        bool completed_;
+        bool taken_;
+    };
+}
+/// \endcond
+
+/// \brief Common part of handles to asynchronously executed queries and statements.
+///
+/// Handle is created by statement::async_query and statement::async_exec. Copies of handle refer
+/// to the same operation.
+///
+/// Backends with native asynchronous API (PostgreSQL, MySQL) make progress only when ready(), wait_for() or
+/// wait() is called, so the usual pattern is to wait until native_socket() becomes readable, or writable when
+/// wants_write() is true, in external reactor and then call ready(). Other backends execute operation on internal worker thread and native_socket() return -1,
+/// completion handler passed to statement::async_query or statement::async_exec is the way to get notified for them.
+/// Operation is ready before its completion handler returns. get() called from another thread waits for the handler
+/// and rethrows exception escaped from it, after operation itself was checked for errors.
+///
+/// Worker threads don`t own statements. Statement, connection and their backend handles are released on the thread
+/// that destroys the last handle or edba::statement, after worker has finished with them, unless the completion
+/// handler itself keeps copy of them.
+class async_operation
+{
+public:
+    /// Make progress on operation without blocking, return true if it has completed
+    bool ready()
+    {
+        return wait_for(0);
+    }
+
+    /// Wait at most \a timeout_ms milliseconds for operation to complete, return true if it has completed
+    bool wait_for(int timeout_ms)
+    {
+        if (!state_->completed_)
+            state_->completed_ = state_->stmt_->async_wait(timeout_ms);
+
+        return state_->completed_;
+    }
+
+    /// Wait until operation completes
+    void wait()
+    {
+        wait_for(-1);
+    }
+
+    /// Return socket descriptor to wait for readability on, or -1 if operation is executed on worker thread
+    int native_socket()
+    {
+        return state_->conn_->native_socket();
+    }
+
+    /// Return true if operation can make progress only after native_socket() becomes writable, for example
+    /// when query with large parameters doesn`t fit in socket send buffer. Check it again after each ready() call.
+    bool wants_write()
+    {
+        return !state_->completed_ && state_->stmt_->async_wants_write();
+    }
+
+protected:
+    async_operation(const backend::connection_ptr& conn, const backend::statement_ptr& stmt, bool query)
+      : state_(new detail::async_operation_state(conn, stmt, query))
+    {
+    }
+
+    void take(const char* method)
+    {
+        if (state_->taken_)
+            throw edba_error(std::string("edba::async_operation: ") + method + " called for a second time");
+
+        state_->taken_ = true;
+    }
+
+    boost::shared_ptr<detail::async_operation_state> state_;
+};
+
+/// \brief Handle to asynchronously executed query
+class async_query_result : public async_operation
+{
+public:
+    /// Wait until query completes and return its result. Rethrow error occurred during execution.
+    /// May be called only once.
+    rowset<> get()
+    {
+        take("get");
+        return rowset<>(state_->conn_, state_->stmt_, state_->stmt_->async_query_result());
+    }
+
+private:
+    friend class statement;
+
+    async_query_result(const backend::connection_ptr& conn, const backend::statement_ptr& stmt)
+      : async_operation(conn, stmt, true)
+    {
+    }
+};
+
+/// \brief Handle to asynchronously executed statement
+class async_exec_result : public async_operation
+{
+public:
+    /// Wait until statement completes. Rethrow error occurred during execution.
+    /// May be called only once, after that statement::affected() and statement::last_insert_id() can be used.
+    void get()
+    {
+        take("get");
+        state_->stmt_->async_exec_result();
+    }
+
+private:
+    friend class statement;
+
+    async_exec_result(const backend::connection_ptr& conn, const backend::statement_ptr& stmt)
+      : async_operation(conn, stmt, false)
+    {
+    }
+};
+
+}
+
+#endif // EDBA_ASYNC_RESULT_HPP
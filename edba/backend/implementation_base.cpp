@@ -1,6 +1,7 @@
 #include <edba/backend/implementation_base.hpp>
 #include <edba/session_monitor.hpp>
 #include <edba/conn_info.hpp>
+#include <edba/errors.hpp>
 
 #include <edba/detail/utils.hpp>
 
@@ -9,9 +10,20 @@
 #include <boost/range/algorithm/sort.hpp>
 #include <boost/typeof/typeof.hpp>
 #include <boost/timer.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/once.hpp>
 
 #include <map>
 #include <list>
+#include <deque>
+#include <algorithm>
+
+#ifndef BOOST_NO_CXX11_HDR_EXCEPTION
+#  include <exception>
+#endif
 
 namespace edba { namespace backend {
 
@@ -19,6 +31,143 @@ EDBA_ADD_INTRUSIVE_PTR_SUPPORT_FOR_TYPE_IMPL(result_iface)
 EDBA_ADD_INTRUSIVE_PTR_SUPPORT_FOR_TYPE_IMPL(statement_iface)
 EDBA_ADD_INTRUSIVE_PTR_SUPPORT_FOR_TYPE_IMPL(connection_iface)
 
+namespace {
+
+/// Threads that execute blocking statements for backends without native asynchronous API.
+/// Pool is created on first use. It is destroyed together with other statics at exit or when edba library is
+/// unloaded, before statics of backends that were loaded earlier. Destructor lets queued and running jobs finish
+/// and joins threads, so no backend code runs during later static destruction.
+class worker_pool : boost::noncopyable
+{
+public:
+    static worker_pool& instance()
+    {
+        static boost::once_flag once = BOOST_ONCE_INIT;
+        boost::call_once(&worker_pool::create, once);
+        return *instance_;
+    }
+
+    ~worker_pool()
+    {
+        {
+            boost::mutex::scoped_lock g(guard_);
+            stop_ = true;
+            cv_.notify_all();
+        }
+
+        threads_.join_all();
+    }
+
+    void post(const boost::function<void()>& job)
+    {
+        boost::mutex::scoped_lock g(guard_);
+        jobs_.push_back(job);
+        cv_.notify_one();
+    }
+
+private:
+    worker_pool() : stop_(false)
+    {
+        unsigned threads = (std::max)(2u, boost::thread::hardware_concurrency());
+        for(unsigned i = 0; i < threads; ++i)
+            threads_.create_thread(boost::bind(&worker_pool::run, this));
+    }
+
+    static void create()
+    {
+        static worker_pool pool;
+        instance_ = &pool;
+    }
+
+    void run()
+    {
+        for(;;)
+        {
+            boost::function<void()> job;
+            {
+                boost::mutex::scoped_lock g(guard_);
+                while(jobs_.empty() && !stop_)
+                    cv_.wait(g);
+
+                if(jobs_.empty())
+                    return;
+
+                job.swap(jobs_.front());
+                jobs_.pop_front();
+            }
+
+            job();
+        }
+    }
+
+    static worker_pool* instance_;
+
+    boost::mutex guard_;
+    boost::condition_variable cv_;
+    std::deque< boost::function<void()> > jobs_;
+    boost::thread_group threads_;
+    bool stop_;
+};
+
+worker_pool* worker_pool::instance_ = 0;
+
+/// Append value of single cell to column vector using result_iface::fetch
+class fetch_cell : public boost::static_visitor<>
+{
+public:
+    fetch_cell(result_iface& res, column_buffer& buf, std::size_t row)
+      : res_(res)
+      , buf_(buf)
+      , row_(row)
+    {
+    }
+
+    template<typename T>
+    void operator()(std::vector<T>* v) const
+    {
+        v->push_back(T());
+        if (res_.fetch(buf_.column, &v->back()))
+            buf_.set_valid(row_);
+        else
+            ++buf_.null_count;
+    }
+
+private:
+    result_iface& res_;
+    column_buffer& buf_;
+    std::size_t row_;
+};
+
+}
+
+//////////////
+//result
+//////////////
+
+std::size_t result::fetch_batch(std::size_t n, std::vector<column_buffer>& buffers)
+{
+    int columns = cols();
+    for (std::size_t i = 0; i < buffers.size(); ++i)
+    {
+        if (buffers[i].column < 0 || buffers[i].column >= columns)
+            throw invalid_column(buffers[i].column);
+
+        buffers[i].reset(n);
+    }
+
+    std::size_t row = 0;
+    for (; row < n && next(); ++row)
+    {
+        for (std::size_t i = 0; i < buffers.size(); ++i)
+        {
+            fetch_cell visitor(*this, buffers[i], row);
+            buffers[i].values.apply_visitor(visitor);
+        }
+    }
+
+    return row;
+}
+
 //////////////
 //statement
 //////////////
@@ -62,6 +211,304 @@ void statement::run_exec()
     exec_impl();
 }
 
+struct statement::async_state
+{
+    async_state() : active(false), query(false), done(false), notified(false), running(false) {}
+
+    boost::mutex guard;
+    boost::condition_variable cv;
+
+    bool active;                              // async_start was called, result was not taken yet
+    bool query;                               // run query_impl instead of exec_impl
+    bool done;                                // execution on worker thread has completed
+    bool notified;                            // completion handler was called
+    bool running;                             // job is queued or executed by worker thread
+    boost::thread::id worker;                 // thread that executes job
+    boost::function<void()> on_complete;
+
+    result_ptr result;
+#ifndef BOOST_NO_CXX11_HDR_EXCEPTION
+    std::exception_ptr error;
+    std::exception_ptr handler_error;         // thrown by completion handler, rethrown after result is taken
+#else
+    bool failed;
+    std::string error_message;
+    bool handler_failed;
+    std::string handler_error_message;
+#endif
+};
+
+void statement::before_destroy()
+{
+    // Worker thread doesn`t own statement, wait until it stops using it before backend closes its handles. Statement
+    // is destroyed on worker thread only when completion handler holds the last reference to it, worker doesn`t touch
+    // it after handler returns
+    if(async_)
+    {
+        boost::mutex::scoped_lock g(async_->guard);
+        while(async_->running && async_->worker != boost::this_thread::get_id())
+            async_->cv.wait(g);
+    }
+}
+
+void statement::async_start(bool query, const boost::function<void()>& on_complete)
+{
+    if(!async_)
+        async_.reset(new async_state);
+    else if(async_->active)
+        throw edba_error("edba::backend::statement: asynchronous execution is already in progress");
+
+    async_->active = true;
+    async_->query = query;
+    async_->done = false;
+    async_->notified = false;
+    async_->on_complete = on_complete;
+    async_->result.reset();
+#ifndef BOOST_NO_CXX11_HDR_EXCEPTION
+    async_->error = std::exception_ptr();
+    async_->handler_error = std::exception_ptr();
+#else
+    async_->failed = false;
+    async_->error_message.clear();
+    async_->handler_failed = false;
+    async_->handler_error_message.clear();
+#endif
+
+    stat_.start_async();
+
+    try
+    {
+        async_start_impl(query);
+    }
+    catch(...)
+    {
+        async_->active = false;
+        throw;
+    }
+}
+
+bool statement::async_wait(int timeout_ms)
+{
+    if(!async_ || !async_->active)
+        throw edba_error("edba::backend::statement: there is no asynchronous execution in progress");
+
+    bool completed = async_wait_impl(timeout_ms);
+    if(completed)
+        async_completed();
+
+    return completed;
+}
+
+bool statement::async_wants_write()
+{
+    if(!async_ || !async_->active)
+        throw edba_error("edba::backend::statement: there is no asynchronous execution in progress");
+
+    return async_wants_write_impl();
+}
+
+result_ptr statement::async_query_result()
+{
+    async_wait(-1);
+    async_->active = false;
+
+    result_ptr r;
+    {
+        statement_stat::measure_query m(&stat_, &patched_query(), &r, true);
+        r = async_query_result_impl();
+    }
+
+    async_rethrow_handler_error();
+    return r;
+}
+
+void statement::async_exec_result()
+{
+    async_wait(-1);
+    async_->active = false;
+
+    {
+        statement_stat::measure_statement m(&stat_, &patched_query(), this, true);
+        async_exec_result_impl();
+    }
+
+    async_rethrow_handler_error();
+}
+
+void statement::async_rethrow_handler_error()
+{
+    boost::mutex::scoped_lock g(async_->guard);
+
+    // Operation is ready before its completion handler returns, result is taken only after that unless it is taken
+    // from the handler itself
+    while(async_->running && async_->worker != boost::this_thread::get_id())
+        async_->cv.wait(g);
+
+#ifndef BOOST_NO_CXX11_HDR_EXCEPTION
+    if(async_->handler_error)
+        std::rethrow_exception(async_->handler_error);
+#else
+    if(async_->handler_failed)
+        throw edba_error(async_->handler_error_message);
+#endif
+}
+
+void statement::async_completed()
+{
+    boost::function<void()> handler;
+    async_notify(handler);
+}
+
+void statement::async_notify(boost::function<void()>& handler)
+{
+    {
+        boost::mutex::scoped_lock g(async_->guard);
+        if(async_->notified)
+            return;
+
+        async_->notified = true;
+        handler.swap(async_->on_complete);
+        stat_.complete_async();
+    }
+
+    // Handler may be called on worker thread where exception would terminate the process,
+    // so exception is kept and rethrown to the thread that takes the result
+    if(handler)
+    {
+        try
+        {
+            handler();
+        }
+        catch(...)
+        {
+            boost::mutex::scoped_lock g(async_->guard);
+#ifndef BOOST_NO_CXX11_HDR_EXCEPTION
+            async_->handler_error = std::current_exception();
+#else
+            async_->handler_failed = true;
+            try { throw; }
+            catch(const std::exception& e) { async_->handler_error_message = e.what(); }
+            catch(...) { async_->handler_error_message = "unknown error"; }
+#endif
+        }
+    }
+}
+
+void statement::async_start_impl(bool)
+{
+    // Job doesn`t hold reference to statement, otherwise the last one could be released on worker thread and
+    // backend would close its handles there. Statement is kept alive by async_operation that waits for completion
+    // and by before_destroy that waits until job has finished
+    {
+        boost::mutex::scoped_lock g(async_->guard);
+        async_->running = true;
+    }
+
+    try
+    {
+        worker_pool::instance().post(boost::bind(&statement::async_run, this));
+    }
+    catch(...)
+    {
+        boost::mutex::scoped_lock g(async_->guard);
+        async_->running = false;
+        throw;
+    }
+}
+
+void statement::async_run()
+{
+    // Keep state alive after running is cleared, statement may be destroyed by another thread at that moment
+    boost::shared_ptr<async_state> state(async_);
+    {
+        boost::mutex::scoped_lock g(state->guard);
+        state->worker = boost::this_thread::get_id();
+    }
+
+    result_ptr r;
+    try
+    {
+        if(async_->query)
+            r = query_impl();
+        else
+            exec_impl();
+    }
+    catch(...)
+    {
+        boost::mutex::scoped_lock g(async_->guard);
+#ifndef BOOST_NO_CXX11_HDR_EXCEPTION
+        async_->error = std::current_exception();
+#else
+        async_->failed = true;
+        try { throw; }
+        catch(const std::exception& e) { async_->error_message = e.what(); }
+        catch(...) { async_->error_message = "unknown error"; }
+#endif
+    }
+
+    {
+        boost::mutex::scoped_lock g(async_->guard);
+        async_->result.swap(r);
+        async_->done = true;
+        async_->cv.notify_all();
+    }
+
+    // Handler may hold the last reference to statement, so it is destroyed only after job has finished with it
+    boost::function<void()> handler;
+    async_notify(handler);
+
+    boost::mutex::scoped_lock g(state->guard);
+    state->running = false;
+    state->cv.notify_all();
+}
+
+bool statement::async_wait_impl(int timeout_ms)
+{
+    boost::mutex::scoped_lock g(async_->guard);
+
+    if(timeout_ms < 0)
+    {
+        while(!async_->done)
+            async_->cv.wait(g);
+    }
+    else if(!async_->done && timeout_ms > 0)
+    {
+        boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(timeout_ms);
+        while(!async_->done)
+            if(!async_->cv.timed_wait(g, deadline))
+                break;
+    }
+
+    return async_->done;
+}
+
+bool statement::async_wants_write_impl()
+{
+    return false;
+}
+
+result_ptr statement::async_query_result_impl()
+{
+    boost::mutex::scoped_lock g(async_->guard);
+
+#ifndef BOOST_NO_CXX11_HDR_EXCEPTION
+    if(async_->error)
+        std::rethrow_exception(async_->error);
+#else
+    if(async_->failed)
+        throw edba_error(async_->error_message);
+#endif
+
+    result_ptr r;
+    r.swap(async_->result);
+    return r;
+}
+
+void statement::async_exec_result_impl()
+{
+    async_query_result_impl();
+}
+
 //////////////
 //connection
 //////////////
@@ -177,6 +624,31 @@ const conn_info& connection::connection_info() const
     return info_;
 }
 
+void connection::listen(const string_ref&)
+{
+    throw not_supported_by_backend("edba::backend::connection: notifications are not supported by " + backend());
+}
+
+void connection::unlisten(const string_ref&)
+{
+    throw not_supported_by_backend("edba::backend::connection: notifications are not supported by " + backend());
+}
+
+bool connection::wait_notification(notification&, int)
+{
+    throw not_supported_by_backend("edba::backend::connection: notifications are not supported by " + backend());
+}
+
+int connection::native_socket()
+{
+    return -1;
+}
+
+void* connection::get_extension(const string_ref&)
+{
+    return 0;
+}
+
 connection::connection(conn_info const &info, session_monitor* sm)
   : info_(info)
   , stat_(sm)
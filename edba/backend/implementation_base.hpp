@@ -5,14 +5,22 @@
 #include <edba/backend/statistics.hpp>
 #include <edba/conn_info.hpp>
 
+#include <boost/shared_ptr.hpp>
+
 #include <vector>
 #include <utility>
 #include <string>
 
 namespace edba { namespace backend {
 
-class result : public result_iface 
+class EDBA_API result : public result_iface 
 {
+public:
+    ///
+    /// Generic implementation that fetches values cell by cell with next() and fetch().
+    /// Backends override it when they can fill column vectors directly.
+    ///
+    virtual std::size_t fetch_batch(std::size_t n, std::vector<column_buffer>& buffers);
 };
 
 class EDBA_API statement : public statement_iface
@@ -47,6 +55,40 @@ protected:
     ///
     virtual void exec_impl() = 0;
 
+    ///
+    /// Start asynchronous execution of query or statement. Default implementation runs query_impl or exec_impl
+    /// on internal worker thread pool. Backends with native asynchronous API override all async_*_impl methods
+    /// and call async_completed when they detect completion.
+    ///
+    virtual void async_start_impl(bool query);
+
+    ///
+    /// Make progress on asynchronous execution waiting at most \a timeout_ms milliseconds.
+    /// Return true if execution has completed.
+    ///
+    virtual bool async_wait_impl(int timeout_ms);
+
+    ///
+    /// Return true if asynchronous execution waits for socket to become writable, default implementation
+    /// doesn`t use socket and returns false.
+    ///
+    virtual bool async_wants_write_impl();
+
+    ///
+    /// Return result of completed asynchronous query, rethrow error occurred during execution.
+    ///
+    virtual result_ptr async_query_result_impl();
+
+    ///
+    /// Finish completed asynchronous statement, rethrow error occurred during execution.
+    ///
+    virtual void async_exec_result_impl();
+
+    ///
+    /// Call completion handler passed to async_start if it has not been called yet
+    ///
+    void async_completed();
+
 public:
     ///
     /// Bind value to column \a col (starting from 1).
@@ -77,8 +119,44 @@ public:
     ///
     void run_exec();
 
+    ///
+    /// Start asynchronous execution of query or statement.
+    ///
+    void async_start(bool query, const boost::function<void()>& on_complete);
+
+    ///
+    /// Make progress on asynchronous execution, return true if execution has completed.
+    ///
+    bool async_wait(int timeout_ms);
+
+    ///
+    /// Return true if asynchronous execution waits for socket to become writable.
+    ///
+    bool async_wants_write();
+
+    ///
+    /// Return result of completed asynchronous query.
+    ///
+    result_ptr async_query_result();
+
+    ///
+    /// Finish completed asynchronous statement.
+    ///
+    void async_exec_result();
+
 protected:    
+    void before_destroy();
+
     statement_stat stat_; 
+
+private:
+    struct async_state;
+
+    void async_run();
+    void async_notify(boost::function<void()>& handler);
+    void async_rethrow_handler_error();
+
+    boost::shared_ptr<async_state> async_;
 };
 
 class EDBA_API connection : public connection_iface 
@@ -158,6 +236,23 @@ public:
     double total_execution_time() const;
     const conn_info& connection_info() const;
 
+    ///
+    /// Notifications are not supported by default, all methods throw not_supported_by_backend
+    ///
+    void listen(const string_ref& channel);
+    void unlisten(const string_ref& channel);
+    bool wait_notification(notification& n, int timeout_ms);
+
+    ///
+    /// Return -1, backends that communicate with server through socket should override it
+    ///
+    int native_socket();
+
+    ///
+    /// Return null, backends that provide extensions should override it
+    ///
+    void* get_extension(const string_ref& name);
+
 protected:
     typedef std::vector< std::pair<std::string, statement_ptr > > stmt_map;
 
@@ -3,8 +3,11 @@
 
 #include <edba/types.hpp>
 #include <edba/string_ref.hpp>
+#include <edba/notification.hpp>
+#include <edba/column_buffer.hpp>
 
 #include <boost/any.hpp>
+#include <boost/function.hpp>
 
 #include <string>
 
@@ -44,6 +47,15 @@ public:
     ///
     virtual bool fetch(int col, const fetch_types_variant& v) = 0;
 
+    ///
+    /// Fetch at most \a n rows, starting from the row that next() would move to, into \a buffers and return number of
+    /// fetched rows. Return 0 if no rows remain. Subsequent next() call moves to the row following the last fetched one.
+    ///
+    /// Should throw invalid_column() if column of some buffer is invalid, should throw bad_value_cast() if the underlying
+    /// data can't be converted to the element type of buffer.
+    ///
+    virtual std::size_t fetch_batch(std::size_t n, std::vector<column_buffer>& buffers) = 0;
+
     ///
     /// Return true if value is null at specified column
     ///
@@ -126,6 +138,39 @@ struct statement_iface : ref_cnt
     /// Should be called after exec(), otherwise behavior is undefined.
     ///
     virtual unsigned long long affected() = 0;
+
+    ///
+    /// Start asynchronous execution of query if \a query is true or statement otherwise and return immediately.
+    /// \a on_complete (if not empty) is called exactly once after execution has completed, from the thread that
+    /// detected completion. That may be internal worker thread or thread that called async_wait. Exception escaping
+    /// from handler is kept and rethrown by async_query_result or async_exec_result.
+    ///
+    /// Connection must not be used for anything else until execution completes.
+    ///
+    virtual void async_start(bool query, const boost::function<void()>& on_complete) = 0;
+
+    ///
+    /// Make progress on asynchronous execution waiting at most \a timeout_ms milliseconds. Zero timeout means
+    /// don`t block at all, negative timeout means wait until execution completes.
+    /// Return true if execution has completed.
+    ///
+    virtual bool async_wait(int timeout_ms) = 0;
+
+    ///
+    /// Return true if asynchronous execution can make progress only after connection socket becomes writable,
+    /// for example query doesn`t fit in socket send buffer. Otherwise progress is made when socket becomes readable.
+    ///
+    virtual bool async_wants_write() = 0;
+
+    ///
+    /// Return result of completed asynchronous query, rethrow error occurred during execution.
+    ///
+    virtual boost::intrusive_ptr<result_iface> async_query_result() = 0;
+
+    ///
+    /// Finish completed asynchronous statement, rethrow error occurred during execution.
+    ///
+    virtual void async_exec_result() = 0;
 };
 
 struct connection_iface : public ref_cnt
@@ -206,6 +251,36 @@ struct connection_iface : public ref_cnt
     /// Return conn_info object provided for connection during construction
     ///
     virtual const conn_info& connection_info() const = 0;
+
+    ///
+    /// Subscribe connection to notifications sent to \a channel.
+    /// MUST throw not_supported_by_backend() if such option is not supported by the DB engine.
+    ///
+    virtual void listen(const string_ref& channel) = 0;
+    ///
+    /// Cancel subscription to notifications sent to \a channel.
+    /// MUST throw not_supported_by_backend() if such option is not supported by the DB engine.
+    ///
+    virtual void unlisten(const string_ref& channel) = 0;
+    ///
+    /// Wait at most \a timeout_ms milliseconds for notification and store it in \a n. Zero timeout means
+    /// only check for already received notifications, negative timeout means wait infinitely.
+    /// Return false if timeout expired and there is no pending notification.
+    /// MUST throw not_supported_by_backend() if such option is not supported by the DB engine.
+    ///
+    virtual bool wait_notification(notification& n, int timeout_ms) = 0;
+
+    ///
+    /// Return socket descriptor of the connection, can be used to wait for asynchronous operations
+    /// completion in external reactor. Return -1 if backend doesn`t communicate with server through socket.
+    ///
+    virtual int native_socket() = 0;
+
+    ///
+    /// Return backend specific extension interface identified by \a name, or null if backend doesn`t provide it.
+    /// Extension interfaces are declared in public headers, see edba/sqlite3.hpp
+    ///
+    virtual void* get_extension(const string_ref& name) = 0;
 };
 
 }} // namespace edba, backend
@@ -25,6 +25,21 @@ struct dump_to_ostream : boost::static_visitor<>
         os_ << '\'' << format_time(v) << '\'';
     }
 
+    void operator()(const timestamp& v)
+    {
+        os_ << '\'' << format_timestamp(v) << '\'';
+    }
+
+    void operator()(const borrowed_blob&)
+    {
+        os_ << "(BLOB)";
+    }
+
+    void operator()(const blob_ref&)
+    {
+        os_ << "(BLOB)";
+    }
+
     void operator()(std::istream*)
     {
         os_ << "(BLOB)";
@@ -64,19 +79,32 @@ void statement_stat::reset_bindings()
         bindings_.str("");
 }
 
+void statement_stat::start_async()
+{
+    async_start_ = boost::chrono::steady_clock::now();
+    async_time_ = 0.0;
+}
+
+void statement_stat::complete_async()
+{
+    async_time_ = boost::chrono::duration<double>(boost::chrono::steady_clock::now() - async_start_).count();
+}
+
 statement_stat::measure_query::measure_query(
-    statement_stat* stat, const std::string* query, result_ptr* r
+    statement_stat* stat, const std::string* query, result_ptr* r, bool async
   )
   : stat_(stat)
   , query_(query)
   , r_(r)
+  , async_(async)
 {
-    stat_->timer_.restart();
+    if (!async_)
+        stat_->timer_.restart();
 }
 
 statement_stat::measure_query::~measure_query()
 {
-    double execution_time = stat_->timer_.elapsed();
+    double execution_time = async_ ? stat_->async_time_ : stat_->timer_.elapsed();
     stat_->session_stat_->add_query_time(execution_time);
 
     if (stat_->session_stat_->user_monitor())
@@ -101,18 +129,20 @@ statement_stat::measure_query::~measure_query()
 }
 
 statement_stat::measure_statement::measure_statement(
-    statement_stat* stat, const std::string* query, statement_iface* st
+    statement_stat* stat, const std::string* query, statement_iface* st, bool async
   )
   : stat_(stat)
   , query_(query)
   , st_(st)
+  , async_(async)
 {
-    stat_->timer_.restart();
+    if (!async_)
+        stat_->timer_.restart();
 }
 
 statement_stat::measure_statement::~measure_statement()
 {
-    double execution_time = stat_->timer_.elapsed();
+    double execution_time = async_ ? stat_->async_time_ : stat_->timer_.elapsed();
     stat_->session_stat_->add_query_time(execution_time);
 
     if (stat_->session_stat_->user_monitor())
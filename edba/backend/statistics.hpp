@@ -5,6 +5,7 @@
 #include <edba/types.hpp>
 
 #include <boost/timer.hpp>
+#include <boost/chrono/chrono.hpp>
 
 #include <sstream>
 
@@ -62,33 +63,44 @@ private:
 
 struct statement_stat
 {
+    /// Measure execution from construction until destruction, or report time recorded by
+    /// start_async and complete_async when \a async is true
     struct measure_query
     {
-        measure_query(statement_stat* stat, const std::string* query, result_ptr* r);
+        measure_query(statement_stat* stat, const std::string* query, result_ptr* r, bool async = false);
         ~measure_query();
 
     private:
         statement_stat* stat_;
         const std::string* query_;
         result_ptr* r_;
+        bool async_;
     };
 
     struct measure_statement
     {
-        measure_statement(statement_stat* stat, const std::string* query, statement_iface* r);
+        measure_statement(statement_stat* stat, const std::string* query, statement_iface* r, bool async = false);
         ~measure_statement();
 
     private:
         statement_stat* stat_;
         const std::string* query_;
         statement_iface* st_;
+        bool async_;
     };
 
     statement_stat(session_stat* st)
       : session_stat_(st)
+      , async_time_(0.0)
     {
     }
 
+    /// Start measuring asynchronous execution
+    void start_async();
+
+    /// Record wall time elapsed since start_async, may be called from worker thread
+    void complete_async();
+
     void bind(const string_ref& name, const bind_types_variant& val);
     void bind(int col, const bind_types_variant& val);
 
@@ -109,6 +121,13 @@ private:
 
     /// Used to evaluate time spent in query or statement
     boost::timer timer_;
+
+    /// Asynchronous execution mostly waits for server or worker thread, so it is measured with wall clock
+    /// instead of CPU time of the process measured by timer_
+    boost::chrono::steady_clock::time_point async_start_;
+
+    /// Time spent in the last asynchronous execution
+    double async_time_;
 };
 
 
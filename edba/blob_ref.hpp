@@ -0,0 +1,71 @@
+#ifndef EDBA_BLOB_REF_HPP
+#define EDBA_BLOB_REF_HPP
+
+#include <boost/range/iterator_range.hpp>
+
+#include <vector>
+#include <cstddef>
+
+namespace edba
+{
+
+///
+/// \brief Reference to contiguous binary data, bound and fetched as BLOB.
+///
+/// When bound, referenced memory is copied by backends that can`t rely on caller keeping it alive, wrap it with
+/// by_ref to bind it without copying. When fetched, reference points into memory owned by result and stays valid
+/// until the next row is fetched.
+///
+class blob_ref : public boost::iterator_range<const unsigned char*>
+{
+public:
+    blob_ref() {}
+
+    blob_ref(const void* data, std::size_t size)
+      : boost::iterator_range<const unsigned char*>(
+            static_cast<const unsigned char*>(data)
+          , static_cast<const unsigned char*>(data) + size
+          )
+    {}
+
+    explicit blob_ref(const std::vector<unsigned char>& v)
+      : boost::iterator_range<const unsigned char*>(v.empty() ? 0 : &v[0], v.empty() ? 0 : &v[0] + v.size())
+    {}
+
+    /// Return pointer to the first byte as char, as required by most database APIs
+    const char* data() const
+    {
+        return reinterpret_cast<const char*>(begin());
+    }
+};
+
+///
+/// \brief Binary data that is bound without copying, created by by_ref
+///
+class borrowed_blob : public blob_ref
+{
+public:
+    borrowed_blob() {}
+    explicit borrowed_blob(const blob_ref& b) : blob_ref(b) {}
+};
+
+///
+/// Bind \a b without copying it. Caller guarantees that referenced memory stays valid and unchanged until
+/// statement is executed.
+///
+inline borrowed_blob by_ref(const blob_ref& b)
+{
+    return borrowed_blob(b);
+}
+
+///
+/// Bind \a v without copying it. Caller guarantees that vector stays valid and unchanged until statement is executed.
+///
+inline borrowed_blob by_ref(const std::vector<unsigned char>& v)
+{
+    return borrowed_blob(blob_ref(v));
+}
+
+}
+
+#endif // EDBA_BLOB_REF_HPP
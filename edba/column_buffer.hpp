@@ -0,0 +1,122 @@
+#ifndef EDBA_COLUMN_BUFFER_HPP
+#define EDBA_COLUMN_BUFFER_HPP
+
+#include <edba/types.hpp>
+
+#include <boost/variant/static_visitor.hpp>
+#include <boost/variant/apply_visitor.hpp>
+
+#include <vector>
+#include <string>
+#include <ctime>
+
+namespace edba {
+
+/// Column vector types supported by batch fetch
+typedef boost::mpl::vector<
+    std::vector<short>*
+  , std::vector<unsigned short>*
+  , std::vector<int>*
+  , std::vector<unsigned int>*
+  , std::vector<long>*
+  , std::vector<unsigned long>*
+#ifndef BOOST_NO_LONG_LONG
+  , std::vector<long long>*
+  , std::vector<unsigned long long>*
+#endif
+  , std::vector<float>*
+  , std::vector<double>*
+  , std::vector<long double>*
+  , std::vector<std::string>*
+  , std::vector<std::tm>*
+  , std::vector<timestamp>*
+  > batch_types;
+
+typedef boost::make_variant_over<batch_types>::type batch_types_variant;
+
+/// \cond INTERNAL
+namespace detail {
+    struct reset_column_values : boost::static_visitor<>
+    {
+        reset_column_values(std::size_t n) : n_(n) {}
+
+        template<typename T>
+        void operator()(std::vector<T>* v) const
+        {
+            v->clear();
+            v->reserve(n_);
+        }
+
+        std::size_t n_;
+    };
+}
+/// \endcond
+
+///
+/// \brief Destination for values of single column fetched by rowset::fetch_batch.
+///
+/// Values are stored contiguously, one element per fetched row, NULL values are stored as
+/// default constructed elements. Validity bitmap uses Apache Arrow layout: bit i (least significant bit first)
+/// is set when row i has value.
+///
+/// \code
+/// std::vector<int> ids;
+/// std::vector<std::string> names;
+///
+/// std::vector<edba::column_buffer> buffers;
+/// buffers.push_back(edba::column_buffer(0, ids));
+/// buffers.push_back(edba::column_buffer(1, names));
+///
+/// while(rs.fetch_batch(1024, buffers))
+///     process(ids, names, buffers[1].validity);
+/// \endcode
+///
+struct column_buffer
+{
+    ///
+    /// Fetch values of column \a col (starting from 0) into vector \a v
+    ///
+    template<typename T>
+    column_buffer(int col, std::vector<T>& v)
+      : column(col)
+      , values(&v)
+      , null_count(0)
+    {
+    }
+
+    int column;                          ///< Index of source column starting from 0
+    batch_types_variant values;          ///< Vector that receives values
+    std::vector<unsigned char> validity; ///< Validity bitmap, one bit per fetched row
+    std::size_t null_count;              ///< Number of NULL values in the last batch
+
+    ///
+    /// Return true if the value in row \a row of the last batch is NULL
+    ///
+    bool is_null(std::size_t row) const
+    {
+        return !(validity[row >> 3] & (1 << (row & 7)));
+    }
+
+    ///
+    /// Clear values and bitmap before fetching at most \a n rows. Used by backends.
+    ///
+    void reset(std::size_t n)
+    {
+        detail::reset_column_values visitor(n);
+        values.apply_visitor(visitor);
+        validity.assign((n + 7) / 8, 0);
+        null_count = 0;
+    }
+
+    ///
+    /// Mark value in row \a row as not NULL. Used by backends.
+    ///
+    void set_valid(std::size_t row)
+    {
+        validity[row >> 3] |= static_cast<unsigned char>(1 << (row & 7));
+    }
+};
+
+}
+
+#endif // EDBA_COLUMN_BUFFER_HPP
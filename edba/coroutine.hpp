@@ -0,0 +1,279 @@
+#ifndef EDBA_COROUTINE_HPP
+#define EDBA_COROUTINE_HPP
+
+#include <edba/statement.hpp>
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#  if __has_include(<coroutine>)
+#    define EDBA_HAS_COROUTINES
+#  endif
+#endif
+
+#ifdef EDBA_HAS_COROUTINES
+
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+
+namespace edba { namespace coro {
+
+/// \brief Event loop used by awaitables to suspend coroutines until database operation completes.
+///
+/// Implement it on top of your reactor (asio, libuv, epoll loop) to resume coroutines on reactor thread.
+struct reactor
+{
+    virtual ~reactor() {}
+
+    /// Call \a cb once, when socket \a fd becomes readable
+    virtual void when_readable(int fd, std::function<void()> cb) = 0;
+
+    /// Call \a cb once, when socket \a fd becomes writable
+    virtual void when_writable(int fd, std::function<void()> cb) = 0;
+
+    /// Call \a cb once on reactor thread as soon as possible. May be called from other threads.
+    virtual void post(std::function<void()> cb) = 0;
+};
+
+/// \cond INTERNAL
+namespace detail {
+
+    /// State shared by awaiter and completion handler that may be called from worker thread
+    struct completion_state
+    {
+        std::mutex guard_;
+        bool done_ = false;
+        std::coroutine_handle<> waiting_;
+        reactor* reactor_ = nullptr;
+
+        void complete()
+        {
+            std::coroutine_handle<> h;
+            {
+                std::lock_guard<std::mutex> g(guard_);
+                done_ = true;
+                h = waiting_;
+                waiting_ = nullptr;
+            }
+
+            if (!h)
+                return;
+
+            if (reactor_)
+                reactor_->post([h] { h.resume(); });
+            else
+                h.resume();
+        }
+
+        /// Return false if operation has already completed and coroutine should not be suspended
+        bool suspend(std::coroutine_handle<> h)
+        {
+            std::lock_guard<std::mutex> g(guard_);
+            if (done_)
+                return false;
+
+            waiting_ = h;
+            return true;
+        }
+    };
+
+    /// Common implementation of query and statement awaiters.
+    ///
+    /// Operation is started in await_ready. If backend has native asynchronous API (socket is available)
+    /// coroutine waits for socket readability (or writability while query is being sent) in reactor, or if there is no
+    /// reactor operation is completed synchronously.
+    /// Otherwise operation runs on worker pool and coroutine is resumed by completion handler, on reactor thread
+    /// if reactor is provided and on worker thread if it is not.
+    template<typename Handle>
+    class operation_awaiter
+    {
+    public:
+        operation_awaiter(statement st, reactor* r)
+          : st_(std::move(st))
+          , state_(std::make_shared<completion_state>())
+        {
+            state_->reactor_ = r;
+        }
+
+        bool await_ready()
+        {
+            std::shared_ptr<completion_state> state = state_;
+            handle_ = start(st_, [state] { state->complete(); });
+            return handle_->ready();
+        }
+
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            if (handle_->native_socket() < 0)
+                return state_->suspend(h);
+
+            if (!state_->reactor_)
+            {
+                handle_->wait();
+                return false;
+            }
+
+            if (!state_->suspend(h))
+                return false;
+
+            arm();
+            return true;
+        }
+
+        auto await_resume()
+        {
+            return handle_->get();
+        }
+
+    private:
+        static Handle start(statement& st, std::function<void()> cb)
+        {
+            if constexpr (std::is_same_v<Handle, async_query_result>)
+                return st.async_query(cb);
+            else
+                return st.async_exec(cb);
+        }
+
+        // Operation is driven by ready() calls, completion handler called inside of ready() resumes coroutine.
+        // Server doesn`t answer until it has read the whole query, so socket is waited for writability while
+        // backend has unsent data
+        void arm()
+        {
+            reactor* r = state_->reactor_;
+            auto progress = [this] {
+                if (!handle_->ready())
+                    arm();
+            };
+
+            if (handle_->wants_write())
+                r->when_writable(handle_->native_socket(), progress);
+            else
+                r->when_readable(handle_->native_socket(), progress);
+        }
+
+        statement st_;
+        std::shared_ptr<completion_state> state_;
+        std::optional<Handle> handle_;
+    };
+}
+/// \endcond
+
+/// \brief Awaitable that executes query and produces rowset<>
+///
+/// \code
+/// edba::rowset<> rs = co_await edba::coro::query(sess << "select * from users where id = ?" << id, &my_reactor);
+/// \endcode
+class query
+{
+public:
+    /// Execute query of statement \a st, suspend awaiting coroutine using reactor \a r or without it if \a r is null
+    explicit query(statement st, reactor* r = nullptr)
+      : st_(std::move(st))
+      , r_(r)
+    {
+    }
+
+    detail::operation_awaiter<async_query_result> operator co_await() &&
+    {
+        return detail::operation_awaiter<async_query_result>(std::move(st_), r_);
+    }
+
+private:
+    statement st_;
+    reactor* r_;
+};
+
+/// \brief Awaitable that executes statement, see query for details
+///
+/// \code
+/// co_await edba::coro::exec(sess << "delete from users where id = ?" << id, &my_reactor);
+/// \endcode
+class exec
+{
+public:
+    /// Execute statement \a st, suspend awaiting coroutine using reactor \a r or without it if \a r is null
+    explicit exec(statement st, reactor* r = nullptr)
+      : st_(std::move(st))
+      , r_(r)
+    {
+    }
+
+    detail::operation_awaiter<async_exec_result> operator co_await() &&
+    {
+        return detail::operation_awaiter<async_exec_result>(std::move(st_), r_);
+    }
+
+private:
+    statement st_;
+    reactor* r_;
+};
+
+/// \brief Asynchronous iteration over rowset
+///
+/// PostgreSQL and MySQL have whole result received by the time query completes and SQLite reads rows from local
+/// database, so advancing to next row completes without suspension.
+///
+/// \code
+/// edba::coro::row_reader<> rows(co_await edba::coro::query(st, &my_reactor));
+/// while (co_await rows.next())
+///     std::cout << rows->get<int>("id") << std::endl;
+/// \endcode
+template<typename T = row>
+class row_reader
+{
+    struct next_awaiter
+    {
+        row_reader* reader_;
+
+        bool await_ready() const noexcept { return true; }
+        void await_suspend(std::coroutine_handle<>) const noexcept {}
+        bool await_resume() { return reader_->advance(); }
+    };
+
+public:
+    explicit row_reader(const rowset<T>& rs)
+      : rs_(rs)
+      , started_(false)
+    {
+    }
+
+    // Iterator keeps pointer to rowset, so reader can`t be moved
+    row_reader(const row_reader&) = delete;
+    row_reader& operator=(const row_reader&) = delete;
+
+    /// Advance to the next row, awaiting produce false when there are no more rows
+    next_awaiter next()
+    {
+        return next_awaiter{this};
+    }
+
+    /// Access current row
+    const T& operator*() const { return *it_; }
+    const T* operator->() const { return &*it_; }
+
+private:
+    bool advance()
+    {
+        if (started_)
+            ++it_;
+        else
+        {
+            it_ = rs_.begin();
+            started_ = true;
+        }
+
+        return it_ != rs_.end();
+    }
+
+    rowset<T> rs_;
+    typename rowset<T>::iterator it_;
+    bool started_;
+};
+
+}} // namespace edba, coro
+
+#endif // EDBA_HAS_COROUTINES
+
+#endif // EDBA_COROUTINE_HPP
@@ -0,0 +1,60 @@
+#include <edba/detail/column_names.hpp>
+#include <edba/backend/interfaces.hpp>
+
+#include <algorithm>
+
+namespace edba { namespace detail {
+
+namespace {
+
+struct entry_less
+{
+    template<typename Entry>
+    bool operator()(const Entry& e1, const Entry& e2) const
+    {
+        return e1.first < e2.first || (e1.first == e2.first && e1.second < e2.second);
+    }
+
+    template<typename Entry>
+    bool operator()(const Entry& e, const string_ref& n) const
+    {
+        return std::lexicographical_compare(
+            e.first.begin(), e.first.end()
+          , n.begin(), n.end()
+          , &char_less
+          );
+    }
+
+    // Same order as std::string comparison uses
+    static bool char_less(char c1, char c2)
+    {
+        return (unsigned char)c1 < (unsigned char)c2;
+    }
+};
+
+}
+
+column_names::column_names(backend::result_iface& res)
+{
+    int cols = res.cols();
+    names_.reserve(cols);
+
+    for (int i = 0; i < cols; ++i)
+        names_.push_back(entry(res.column_to_name(i), i));
+
+    std::sort(names_.begin(), names_.end(), entry_less());
+}
+
+int column_names::find(const string_ref& n) const
+{
+    std::vector<entry>::const_iterator p = std::lower_bound(names_.begin(), names_.end(), n, entry_less());
+    if (p == names_.end() || p->first.size() != std::size_t(n.size()))
+        return -1;
+
+    if (!std::equal(p->first.begin(), p->first.end(), n.begin()))
+        return -1;
+
+    return p->second;
+}
+
+}}
@@ -0,0 +1,43 @@
+#ifndef EDBA_DETAIL_COLUMN_NAMES_HPP
+#define EDBA_DETAIL_COLUMN_NAMES_HPP
+
+#include <edba/detail/exports.hpp>
+#include <edba/string_ref.hpp>
+
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace edba {
+
+namespace backend { struct result_iface; }
+
+/// \cond INTERNAL
+namespace detail {
+
+///
+/// \brief Index of result column names as reported by backend, built once per result.
+///
+/// Lookup is a binary search over flat sorted vector without any memory allocation.
+/// Names are compared exactly, other spellings are left to backend rules.
+/// When several columns share the same name the first one is returned.
+///
+class EDBA_API column_names
+{
+public:
+    explicit column_names(backend::result_iface& res);
+
+    /// Return column index by name or -1 if there is no such column
+    int find(const string_ref& n) const;
+
+private:
+    typedef std::pair<std::string, int> entry;
+    std::vector<entry> names_;                              //!< Names sorted by name, then by column
+};
+
+} // detail
+/// \endcond
+
+}
+
+#endif // EDBA_DETAIL_COLUMN_NAMES_HPP
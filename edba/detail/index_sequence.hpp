@@ -0,0 +1,36 @@
+#ifndef EDBA_DETAIL_INDEX_SEQUENCE_HPP
+#define EDBA_DETAIL_INDEX_SEQUENCE_HPP
+
+#include <boost/config.hpp>
+
+#ifndef BOOST_NO_CXX11_VARIADIC_TEMPLATES
+
+#include <cstddef>
+
+namespace edba {
+
+/// \cond INTERNAL
+namespace detail {
+    template<std::size_t... I>
+    struct index_sequence {};
+
+    template<std::size_t N, std::size_t... I>
+    struct make_index_sequence : make_index_sequence<N - 1, N - 1, I...> {};
+
+    template<std::size_t... I>
+    struct make_index_sequence<0, I...>
+    {
+        typedef index_sequence<I...> type;
+    };
+
+    // Pack expansion inside braced initializer is evaluated from left to right,
+    // leading zero keeps array non empty for empty packs
+    typedef int expand_pack[];
+}
+/// \endcond
+
+}
+
+#endif // BOOST_NO_CXX11_VARIADIC_TEMPLATES
+
+#endif // EDBA_DETAIL_INDEX_SEQUENCE_HPP
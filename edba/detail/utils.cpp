@@ -4,108 +4,532 @@
 #include <boost/typeof/typeof.hpp>
 #include <boost/foreach.hpp>
 #include <boost/algorithm/string/find_iterator.hpp>
+#include <boost/predef/other/endian.h>
+#include <boost/cstdint.hpp>
 
-#include <time.h>
-#include <stdio.h>
 #include <string.h>
 #include <sstream>
 #include <locale>
+#include <limits>
 
 
 namespace edba {
 
-std::string format_time(std::tm const &v)
+namespace {
+
+inline bool is_digit(char c)
 {
-    char buf[64]= {0};
-    strftime(buf,sizeof(buf),"%Y-%m-%d %H:%M:%S",&v);
-    return buf;
+    return c >= '0' && c <= '9';
 }
-    
-std::tm parse_time(std::string const &v)
+
+inline bool is_space(char c)
 {
-    if(strlen(v.c_str())!=v.size())
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+#if BOOST_ENDIAN_LITTLE_BYTE
+
+// SWAR digit parsing: 8 ASCII characters are loaded into single 64 bit integer,
+// validated and converted with 3 multiplications instead of 8 iterations.
+
+inline boost::uint64_t load_eight(const char* p)
+{
+    boost::uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline bool is_eight_digits(boost::uint64_t v)
+{
+    return (((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL);
+}
+
+inline boost::uint32_t parse_eight_digits(boost::uint64_t v)
+{
+    const boost::uint64_t mask = 0x000000FF000000FFULL;
+    const boost::uint64_t mul1 = 0x000F424000000064ULL; // 100 + (1000000ULL << 32)
+    const boost::uint64_t mul2 = 0x0000271000000001ULL; // 1 + (10000ULL << 32)
+    v -= 0x3030303030303030ULL;
+    v = (v * 10) + (v >> 8);
+    v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+    return static_cast<boost::uint32_t>(v);
+}
+
+#endif
+
+// Accumulate decimal digits from [p, end) into value, set overflow when value doesn`t fit into 64 bits.
+// Return pointer to first non digit character.
+const char* parse_digits(const char* p, const char* end, boost::uint64_t& value, bool& overflow)
+{
+    const boost::uint64_t max = (std::numeric_limits<boost::uint64_t>::max)();
+
+#if BOOST_ENDIAN_LITTLE_BYTE
+    while (end - p >= 8)
+    {
+        boost::uint64_t chunk = load_eight(p);
+        if (!is_eight_digits(chunk))
+            break;
+
+        boost::uint32_t digits = parse_eight_digits(chunk);
+        if (value > (max - digits) / 100000000)
+            overflow = true;
+
+        value = value * 100000000 + digits;
+        p += 8;
+    }
+#endif
+
+    for (; p != end && is_digit(*p); ++p)
+    {
+        unsigned d = *p - '0';
+        if (value > (max - d) / 10)
+            overflow = true;
+
+        value = value * 10 + d;
+    }
+
+    return p;
+}
+
+const char* skip_spaces(const char* p, const char* end)
+{
+    while (p != end && is_space(*p))
+        ++p;
+    return p;
+}
+
+template<typename T>
+void parse_integer(const string_ref& r, T& num)
+{
+    const char* p = skip_spaces(r.begin(), r.end());
+    const char* end = r.end();
+
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    if (p == end || !is_digit(*p))
         throw bad_value_cast();
-    return parse_time(v.c_str());
+
+    boost::uint64_t value = 0;
+    bool overflow = false;
+    p = parse_digits(p, end, value, overflow);
+
+    // Fractional part of numeric value is truncated
+    if (p != end && *p == '.')
+        for (++p; p != end && is_digit(*p); ++p);
+
+    if (overflow || skip_spaces(p, end) != end)
+        throw bad_value_cast();
+
+    if (!negative)
+    {
+        if (value > static_cast<boost::uint64_t>((std::numeric_limits<T>::max)()))
+            throw bad_value_cast();
+
+        num = static_cast<T>(value);
+    }
+    else if (value == 0)
+        num = 0;
+    else
+    {
+        if (!std::numeric_limits<T>::is_signed)
+            throw bad_value_cast();
+
+        // Absolute value of minimum is greater than maximum by one
+        if (value - 1 > static_cast<boost::uint64_t>((std::numeric_limits<T>::max)()))
+            throw bad_value_cast();
+
+        num = static_cast<T>(-static_cast<T>(value - 1) - 1);
+    }
 }
-std::tm parse_time(char const *v)
+
+bool iequals_ascii(const char* b, const char* e, const char* lower)
+{
+    for (; b != e && *lower; ++b, ++lower)
+    {
+        if ((*b | 0x20) != *lower)
+            return false;
+    }
+    return b == e && !*lower;
+}
+
+// Powers of 10 exactly representable by double
+const double g_exact_powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Limits of Clinger`s fast path: mantissa and power of 10 are exactly representable by T,
+// so single multiplication or division gives correctly rounded result
+template<typename T>
+struct fast_path_limits
 {
-    std::tm t=std::tm();
-    int n;
-    double sec = 0;
-    n = sscanf(v,"%d-%d-%d %d:%d:%lf",
-                &t.tm_year,&t.tm_mon,&t.tm_mday,
-                &t.tm_hour,&t.tm_min,&sec);
-    if(n!=3 && n!=6)
+    static boost::uint64_t max_mantissa() { return boost::uint64_t(1) << 53; }
+    static int max_exponent() { return 22; }
+};
+
+template<>
+struct fast_path_limits<float>
+{
+    static boost::uint64_t max_mantissa() { return boost::uint64_t(1) << 24; }
+    static int max_exponent() { return 10; }
+};
+
+// Parse floating point number. Values with small number of significant digits and small exponent
+// (the absolute majority of numbers stored in databases) are converted by Clinger`s fast path,
+// others are converted by locale independent standard stream which is correctly rounded.
+template<typename T>
+void parse_floating_point(const string_ref& r, T& num)
+{
+    const char* p = skip_spaces(r.begin(), r.end());
+    const char* end = r.end();
+
+    while (end != p && is_space(end[-1]))
+        --end;
+
+    const char* number = p;
+
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    if (p != end && !is_digit(*p) && *p != '.')
     {
+        if (iequals_ascii(p, end, "nan"))
+            num = std::numeric_limits<T>::quiet_NaN();
+        else if (iequals_ascii(p, end, "inf") || iequals_ascii(p, end, "infinity"))
+            num = negative ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity();
+        else
+            throw bad_value_cast();
+        return;
+    }
+
+    boost::uint64_t mantissa = 0;
+    bool overflow = false;
+    int digits = 0;
+    int exponent = 0;
+
+    const char* int_begin = p;
+    p = parse_digits(p, end, mantissa, overflow);
+    digits += int(p - int_begin);
+
+    if (p != end && *p == '.')
+    {
+        const char* frac_begin = ++p;
+        p = parse_digits(p, end, mantissa, overflow);
+        digits += int(p - frac_begin);
+        exponent -= int(p - frac_begin);
+    }
+
+    if (!digits)
         throw bad_value_cast();
+
+    if (p != end && (*p == 'e' || *p == 'E'))
+    {
+        ++p;
+        bool negative_exp = false;
+        if (p != end && (*p == '-' || *p == '+'))
+            negative_exp = *p++ == '-';
+
+        if (p == end || !is_digit(*p))
+            throw bad_value_cast();
+
+        int exp_value = 0;
+        for (; p != end && is_digit(*p); ++p)
+        {
+            if (exp_value < 100000)
+                exp_value = exp_value * 10 + (*p - '0');
+        }
+
+        exponent += negative_exp ? -exp_value : exp_value;
     }
-    t.tm_year-=1900;
-    t.tm_mon-=1;
-    t.tm_isdst = -1;
-    t.tm_sec=static_cast<int>(sec);
-    if(mktime(&t)==-1)
+
+    if (p != end)
         throw bad_value_cast();
+
+    typedef fast_path_limits<T> limits;
+    if (!overflow && mantissa <= limits::max_mantissa() && exponent >= -limits::max_exponent() && exponent <= limits::max_exponent())
+    {
+        T value = static_cast<T>(mantissa);
+        if (exponent < 0)
+            value /= static_cast<T>(g_exact_powers_of_ten[-exponent]);
+        else
+            value *= static_cast<T>(g_exact_powers_of_ten[exponent]);
+
+        num = negative ? -value : value;
+        return;
+    }
+
+    std::istringstream ss(std::string(number, end));
+    ss.imbue(std::locale::classic());
+    ss >> num;
+    if (ss.fail() || !ss.eof())
+        throw bad_value_cast();
+}
+
+}
+
+namespace {
+
+boost::int64_t floor_div(boost::int64_t a, boost::int64_t b)
+{
+    return a / b - (a % b < 0 ? 1 : 0);
+}
+
+// Read unsigned decimal field of at most 9 digits, return false if there are no digits
+bool read_field(const char*& p, const char* end, int& value)
+{
+    const char* begin = p;
+    value = 0;
+    for (; p != end && is_digit(*p); ++p)
+    {
+        if (p - begin == 9)
+            return false;
+        value = value * 10 + (*p - '0');
+    }
+    return p != begin;
+}
+
+bool expect(const char*& p, const char* end, char c)
+{
+    if (p == end || *p != c)
+        return false;
+    ++p;
+    return true;
+}
+
+// Skip timezone designator (Z, +hh, +hhmm, +hh:mm) as it was always ignored
+const char* skip_timezone(const char* p, const char* end)
+{
+    if (p != end && (*p == 'Z' || *p == 'z'))
+        return p + 1;
+
+    if (p != end && (*p == '+' || *p == '-') && end - p > 1 && is_digit(p[1]))
+    {
+        for (++p; p != end && (is_digit(*p) || *p == ':'); ++p);
+    }
+
+    return p;
+}
+
+void append_padded(std::string& out, boost::int64_t value, int width)
+{
+    char buf[24];
+    int len = 0;
+
+    bool negative = value < 0;
+    boost::uint64_t v = negative ? boost::uint64_t(0) - boost::uint64_t(value) : boost::uint64_t(value);
+    do
+    {
+        buf[len++] = char('0' + v % 10);
+        v /= 10;
+    } while (v);
+
+    while (len < width)
+        buf[len++] = '0';
+
+    if (negative)
+        out += '-';
+
+    while (len)
+        out += buf[--len];
+}
+
+}
+
+boost::int64_t days_from_civil(boost::int64_t y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    boost::int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = static_cast<unsigned>(y - era * 400);
+    unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<boost::int64_t>(doe) - 719468;
+}
+
+void civil_from_days(boost::int64_t days, boost::int64_t& y, unsigned& m, unsigned& d)
+{
+    days += 719468;
+    boost::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned doe = static_cast<unsigned>(days - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<boost::int64_t>(yoe) + era * 400 + (m <= 2);
+}
+
+std::tm make_time(boost::int64_t days, int seconds_of_day)
+{
+    boost::int64_t y;
+    unsigned m, d;
+    civil_from_days(days, y, m, d);
+
+    if (y - 1900 > (std::numeric_limits<int>::max)() || y - 1900 < (std::numeric_limits<int>::min)())
+        throw bad_value_cast();
+
+    std::tm t = std::tm();
+    t.tm_year = int(y - 1900);
+    t.tm_mon = int(m) - 1;
+    t.tm_mday = int(d);
+    t.tm_hour = seconds_of_day / 3600;
+    t.tm_min = seconds_of_day / 60 % 60;
+    t.tm_sec = seconds_of_day % 60;
+    t.tm_yday = int(days - days_from_civil(y, 1, 1));
+    // 1970-01-01 was Thursday
+    t.tm_wday = int(days - floor_div(days + 4, 7) * 7 + 4);
+    t.tm_isdst = -1;
     return t;
 }
 
-template<typename T>
-void parse_number_impl(const string_ref& r, const char* fmt, T& res)
+std::tm parse_time(const string_ref& v, int& microseconds)
+{
+    const char* p = skip_spaces(v.begin(), v.end());
+    const char* end = v.end();
+
+    int year, month, day, hour = 0, minute = 0, sec = 0;
+    microseconds = 0;
+
+    if (!read_field(p, end, year) || !expect(p, end, '-') ||
+        !read_field(p, end, month) || !expect(p, end, '-') ||
+        !read_field(p, end, day))
+    {
+        throw bad_value_cast();
+    }
+
+    if (p != end && (*p == 'T' || *p == 't' || (is_space(*p) && skip_spaces(p, end) != end)))
+    {
+        p = is_space(*p) ? skip_spaces(p, end) : p + 1;
+        if (!read_field(p, end, hour) || !expect(p, end, ':') ||
+            !read_field(p, end, minute) || !expect(p, end, ':') ||
+            !read_field(p, end, sec))
+        {
+            throw bad_value_cast();
+        }
+
+        if (p != end && *p == '.')
+        {
+            int scale = 100000;
+            for (++p; p != end && is_digit(*p); ++p, scale /= 10)
+                microseconds += (*p - '0') * scale;
+        }
+
+        p = skip_timezone(p, end);
+    }
+
+    if (skip_spaces(p, end) != end)
+        throw bad_value_cast();
+
+    // Normalize out of range fields the same way as mktime does
+    boost::int64_t months = boost::int64_t(year) * 12 + month - 1;
+    boost::int64_t seconds = boost::int64_t(hour) * 3600 + boost::int64_t(minute) * 60 + sec;
+    boost::int64_t days = days_from_civil(floor_div(months, 12), unsigned(months - floor_div(months, 12) * 12) + 1, 1)
+        + day - 1 + floor_div(seconds, 86400);
+
+    return make_time(days, int(seconds - floor_div(seconds, 86400) * 86400));
+}
+
+std::tm parse_time(char const *v)
 {
-    char buf[32];
-    EDBA_STRNCPY(buf, r.begin(), r.size());
-    if (0 == sscanf(buf, fmt, &res))
+    int microseconds;
+    return parse_time(string_ref(v), microseconds);
+}
+
+std::tm parse_time(std::string const &v)
+{
+    if(strlen(v.c_str())!=v.size())
         throw bad_value_cast();
+    return parse_time(v.c_str());
+}
+
+std::string format_time(std::tm const &v, int microseconds)
+{
+    std::string out;
+    out.reserve(32);
+
+    append_padded(out, boost::int64_t(v.tm_year) + 1900, 4);
+    out += '-';
+    append_padded(out, v.tm_mon + 1, 2);
+    out += '-';
+    append_padded(out, v.tm_mday, 2);
+    out += ' ';
+    append_padded(out, v.tm_hour, 2);
+    out += ':';
+    append_padded(out, v.tm_min, 2);
+    out += ':';
+    append_padded(out, v.tm_sec, 2);
+
+    if (microseconds)
+    {
+        out += '.';
+        append_padded(out, microseconds, 6);
+    }
+
+    return out;
 }
+
+std::string format_time(std::tm const &v)
+{
+    return format_time(v, 0);
+}
+
 void parse_number(const string_ref& r, short& num)
 {
-    parse_number_impl(r, "%hd", num);
+    parse_integer(r, num);
 }
 void parse_number(const string_ref& r, unsigned short& num)
 {
-    parse_number_impl(r, "%hu", num);
+    parse_integer(r, num);
 }
 void parse_number(const string_ref& r, int& num)
 {
-    parse_number_impl(r, "%d", num);
+    parse_integer(r, num);
 }
 void parse_number(const string_ref& r, unsigned int& num)
 {
-    parse_number_impl(r, "%u", num);
+    parse_integer(r, num);
 }
 void parse_number(const string_ref& r, long& num)
 {
-    parse_number_impl(r, "%ld", num);
+    parse_integer(r, num);
 }
 void parse_number(const string_ref& r, unsigned long& num)
 {
-    parse_number_impl(r, "%lu", num);
+    parse_integer(r, num);
 }
 void parse_number(const string_ref& r, long long& num)
 {
-    parse_number_impl(r, "%lld", num);
+    parse_integer(r, num);
 }
 void parse_number(const string_ref& r, unsigned long long& num)
 {
-    parse_number_impl(r, "%llu", num);
+    parse_integer(r, num);
 }
 void parse_number(const string_ref& r, float& num)
 {
-    parse_number_impl(r, "%f", num);
+    parse_floating_point(r, num);
 }
 void parse_number(const string_ref& r, double& num)
 {
-    parse_number_impl(r, "%lf", num);
+    parse_floating_point(r, num);
 }
 void parse_number(const string_ref& r, long double& num)
 {
-    parse_number_impl(r, "%Lf", num);
+    parse_floating_point(r, num);
 }
 
 int parse_int_no_throw(const string_ref& r)
 {
-    char buf[std::numeric_limits<int>::digits10 + 1];
-    EDBA_STRNCPY(buf, r.begin(), r.size());
-    return atoi(buf);
+    boost::uint64_t value = 0;
+    bool overflow = false;
+    parse_digits(skip_spaces(r.begin(), r.end()), r.end(), value, overflow);
+
+    if (overflow || value > boost::uint64_t((std::numeric_limits<int>::max)()))
+        return 0;
+
+    return int(value);
 }
 
 string_ref select_statement(
@@ -10,6 +10,7 @@
 #include <boost/preprocessor/stringize.hpp>
 #include <boost/intrusive_ptr.hpp>
 #include <boost/noncopyable.hpp>
+#include <boost/cstdint.hpp>
 
 #include <cstdio>
 #include <string>
@@ -71,6 +72,33 @@ EDBA_API std::string format_time(std::tm const &v);
 /// Used by backend implementations;
 ///
 EDBA_API std::tm parse_time(std::string const &v);
+///
+/// \brief parse ISO-8601 date or date and time with optional fractional seconds that are stored
+/// into \a microseconds. Out of range fields are normalized, timezone designator is ignored.
+///
+/// Used by backend implementations;
+///
+EDBA_API std::tm parse_time(const string_ref& v, int& microseconds);
+///
+/// \brief format a string as time value with fractional seconds, if \a microseconds is not 0.
+///
+/// Used by backend implementations;
+///
+EDBA_API std::string format_time(std::tm const &v, int microseconds);
+///
+/// \brief Return normalized time for number of \a days since 1970-01-01 and \a seconds_of_day.
+///
+/// Used by backend implementations;
+///
+EDBA_API std::tm make_time(boost::int64_t days, int seconds_of_day);
+///
+/// \brief Return number of days since 1970-01-01 for date of proleptic Gregorian calendar.
+///
+EDBA_API boost::int64_t days_from_civil(boost::int64_t y, unsigned m, unsigned d);
+///
+/// \brief Convert number of days since 1970-01-01 to date of proleptic Gregorian calendar.
+///
+EDBA_API void civil_from_days(boost::int64_t days, boost::int64_t& y, unsigned& m, unsigned& d);
 
 template<typename IterRange>
 void trim(IterRange& rng)
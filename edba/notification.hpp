@@ -0,0 +1,23 @@
+#ifndef EDBA_NOTIFICATION_HPP
+#define EDBA_NOTIFICATION_HPP
+
+#include <string>
+
+namespace edba {
+
+/// \brief Asynchronous notification delivered by database server to listening session
+///
+/// Notifications are produced by NOTIFY statement (or pg_notify function) in PostgreSQL and
+/// are received only for channels that were subscribed with session::listen
+struct notification
+{
+    notification() : backend_pid(0) {}
+
+    std::string channel;   ///< Name of the channel notification was sent to
+    std::string payload;   ///< Payload string, empty if it was not provided by sender
+    int backend_pid;       ///< Process id of the server backend that sent notification
+};
+
+}
+
+#endif // EDBA_NOTIFICATION_HPP
@@ -2,25 +2,72 @@
 #define EDBA_ROWSET_HPP
 
 #include <edba/backend/interfaces.hpp>
+#include <edba/detail/column_names.hpp>
 
 #include <boost/logic/tribool.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/move/iterator.hpp>
+#include <boost/move/utility.hpp>
+
+#include <algorithm>
+#include <limits>
 
 namespace edba {
 
 namespace detail {
     template<typename T>
     struct value_holder { T value_; };
+
+    // Containers without reserve grow as they are
+    template<typename Container>
+    void reserve_rows(Container&, std::size_t) {}
+
+    template<typename T, typename A>
+    void reserve_rows(std::vector<T, A>& c, std::size_t n)
+    {
+        c.reserve(c.size() + n);
+    }
 }
 
+namespace sqlite3 { class function_context; }
+
 class row;
 template<typename Row> class rowset_iterator;
 template<typename Row> class rowset;
 
+///
+/// \brief Column index resolved by name once per rowset, see rowset::column_handle.
+///
+/// Fetching by handle costs the same as fetching by index, while the query text
+/// remains the only place that defines the order of columns.
+///
+class column_handle
+{
+    template<typename T> friend class rowset;
+
+    explicit column_handle(int col) : col_(col) {}
+
+public:
+    column_handle() : col_(-1) {}
+
+    ///
+    /// Return column index (starting from 0), or -1 for default constructed handle
+    ///
+    int index() const
+    {
+        return col_;
+    }
+
+private:
+    int col_;
+};
+
 /// Represent single row in row set.
 class row
 {
     template<typename T> friend class rowset_iterator;
     template<typename T> friend class rowset;
+    friend class sqlite3::function_context;
 
     // Row doesn`t support construction by user, only by rowset
     row(const backend::connection_ptr& conn
@@ -48,11 +95,15 @@ public:
     ///
     bool is_null(const string_ref& n) const
     {
-        int c = res_->name_to_column(n);
-        if (c < 0)
-            throw invalid_column(std::string(n.begin(), n.end()));
+        return res_->is_null(column_index(n));
+    }
 
-        res_->is_null(c);
+    ///
+    /// Return true if the column referenced by \a c has NULL value
+    ///
+    bool is_null(const column_handle& c) const
+    {
+        return res_->is_null(c.index());
     }
 
     ///
@@ -100,10 +151,20 @@ public:
     template<typename T>
     bool fetch(const string_ref& n, T& v) const
     {
-        int c = res_->name_to_column(n);
-        if (c < 0)
-            throw invalid_column(std::string(n.begin(), n.end()));
-        return fetch(c, v);
+        return fetch(column_index(n), v);
+    }
+
+    ///
+    /// Fetch a value from column referenced by \a c into \a v. Returns false
+    /// if the value in NULL and \a v is not updated, otherwise returns true.
+    ///
+    /// If the data type is not same it tries to cast the data, if casting fails or the
+    /// data is out of the type range, throws bad_value_cast().
+    ///
+    template<typename T>
+    bool fetch(const column_handle& c, T& v) const
+    {
+        return fetch(c.index(), v);
     }
 
     ///
@@ -154,6 +215,30 @@ public:
             throw null_value_fetch(std::string(name.begin(), name.end()));
     }
 
+    ///
+    /// Get a value of type \a T from column referenced by \a c. If the column
+    /// is null throws null_value_fetch(), if the column index is invalid throws invalid_column,
+    /// if the column value cannot be converted to type T (see fetch functions) it throws bad_value_cast.
+    ///
+    template<typename T>
+    T get(const column_handle& c) const
+    {
+        T v = T();
+        get(c.index(), v);
+        return v;
+    }
+
+    ///
+    /// Get a value of type \a T from column referenced by \a c. If the column
+    /// is null throws null_value_fetch(), if the column index is invalid throws invalid_column,
+    /// if the column value cannot be converted to type T (see fetch functions) it throws bad_value_cast.
+    ///
+    template<typename T>
+    void get(const column_handle& c, T& value) const
+    {
+        get(c.index(), value);
+    }
+
     ///
     /// Get a value of type \a T from column \a col (starting from 0). If the column
     /// is null throws null_value_fetch(), if the column index is invalid throws invalid_column,
@@ -205,6 +290,28 @@ public:
     }
 
 private:
+    // Return column index by name or -1, index of names is built on the first call
+    int find_column(const string_ref& n) const
+    {
+        if (!names_)
+            names_.reset(new detail::column_names(*res_));
+
+        int c = names_->find(n);
+
+        // Backend decides how names that differ from the reported ones match,
+        // e.g. MySQL ignores case and PostgreSQL folds unquoted names to lower case
+        return c < 0 ? res_->name_to_column(n) : c;
+    }
+
+    int column_index(const string_ref& n) const
+    {
+        int c = find_column(n);
+        if (c < 0)
+            throw invalid_column(std::string(n.begin(), n.end()));
+
+        return c;
+    }
+
     // Note that order of members is not random.
     // It is very important to destroy result set then statement then connection
 
@@ -212,6 +319,7 @@ private:
     backend::statement_ptr stmt_;
     backend::result_ptr res_;
     mutable int current_col_;
+    mutable boost::shared_ptr<const detail::column_names> names_;
 };
 
 // -------- free functions related to row ---------
@@ -225,6 +333,15 @@ detail::tag<string_ref, T&> into(const string_ref& name, T& v)
     return detail::tag<string_ref, T&>(name, v);
 }
 
+///
+/// \brief Fetch value by column handle
+///
+template<typename T>
+detail::tag<column_handle, T&> into(const column_handle& c, T& v)
+{
+    return detail::tag<column_handle, T&>(c, v);
+}
+
 ///
 /// \brief Fetch value by index (starting from 0)
 ///
@@ -371,6 +488,7 @@ public:
       )
       : row_(conn, stmt, res)
       , opened_(false)
+      , batched_(false)
     {
     }
 
@@ -400,6 +518,61 @@ public:
         return iter;
     }
 
+    ///
+    /// Fetch at most \a n rows into column vectors described by \a buffers and return number of fetched rows,
+    /// 0 means that no rows remain. Can be called repeatedly but can`t be combined with iteration over rowset.
+    ///
+    /// Throws invalid_column if column of some buffer is invalid, bad_value_cast if value can`t be converted
+    /// to the buffer element type.
+    ///
+    std::size_t fetch_batch(std::size_t n, std::vector<column_buffer>& buffers)
+    {
+        if (opened_ && !batched_)
+            throw multiple_rowset_traverse("attempt to fetch batch from rowset opened for iteration");
+
+        opened_ = batched_ = true;
+        return row_.res_->fetch_batch(n, buffers);
+    }
+
+    ///
+    /// Append all remaining rows to container \a c and return number of appended rows. Container should
+    /// provide push_back and insert(position, first, last), std::vector is reserved by the first call when backend
+    /// knows number of rows. Can be called repeatedly and combined with fetch_n and fetch_batch, but not with
+    /// iteration over rowset.
+    ///
+    /// Rowsets of types supported by column_buffer are read through fetch_batch, rowsets of other types
+    /// row by row. Like iteration, throws null_value_fetch on NULL value.
+    ///
+    template<typename Container>
+    std::size_t fetch_all(Container& c)
+    {
+        return fetch_n(c, (std::numeric_limits<std::size_t>::max)());
+    }
+
+    ///
+    /// Append at most \a n next rows to container \a c and return number of appended rows,
+    /// 0 means that no rows remain. See fetch_all.
+    ///
+    template<typename Container>
+    std::size_t fetch_n(Container& c, std::size_t n)
+    {
+        if (opened_ && !batched_)
+            throw multiple_rowset_traverse("attempt to fetch rows from rowset opened for iteration");
+
+        // rows() is total number of rows, so it is known how many remain only before the first fetch. Later calls
+        // leave geometric growth to container, reserving exact size on each call would copy it every time
+        if (!opened_)
+        {
+            boost::uint64_t total = row_.res_->rows();
+            if (total != boost::uint64_t(-1))
+                detail::reserve_rows(c, std::size_t((std::min)(total, boost::uint64_t(n))));
+        }
+
+        opened_ = batched_ = true;
+
+        return fetch_rows(c, n, boost::mpl::contains<batch_types, std::vector<T>*>());
+    }
+
     ///
     /// Return end iterator for rowset
     ///
@@ -457,11 +630,7 @@ public:
     ///
     int column_index(const string_ref& n) const
     {
-        int c = row_.res_->name_to_column(n);
-        if (c < 0)
-            throw invalid_column(std::string(n.begin(), n.end()));
-
-        return c;
+        return row_.column_index(n);
     }
 
     ///
@@ -469,15 +638,66 @@ public:
     ///
     int find_column(const string_ref& name) const
     {
-        int c = row_.res_->name_to_column(name);
-        if (c < 0)
-            return -1;
-        return c;
+        return row_.find_column(name);
+    }
+
+    ///
+    /// Resolve column name once and return handle for fetching from every row without name lookup.
+    /// Throw invalid_column or error
+    ///
+    edba::column_handle column_handle(const string_ref& n) const
+    {
+        return edba::column_handle(row_.column_index(n));
     }
 
 private:
+    // Number of rows fetched by fetch_n at once through fetch_batch
+    static const std::size_t fetch_rows_batch = 4096;
+
+    template<typename Container>
+    std::size_t fetch_rows(Container& c, std::size_t n, boost::mpl::true_)
+    {
+        std::vector<T> chunk;
+        std::vector<column_buffer> buffers(1, column_buffer(0, chunk));
+
+        std::size_t fetched = 0;
+        while (fetched < n)
+        {
+            std::size_t rows = row_.res_->fetch_batch((std::min)(n - fetched, std::size_t(fetch_rows_batch)), buffers);
+            if (!rows)
+                break;
+
+            if (buffers[0].null_count)
+                throw null_value_fetch(row_.res_->column_to_name(0));
+
+            c.insert(c.end(), boost::make_move_iterator(chunk.begin()), boost::make_move_iterator(chunk.end()));
+            fetched += rows;
+        }
+
+        return fetched;
+    }
+
+    template<typename Container>
+    std::size_t fetch_rows(Container& c, std::size_t n, boost::mpl::false_)
+    {
+        std::size_t fetched = 0;
+        for (; fetched < n && row_.res_->next(); ++fetched)
+        {
+            row_.rewind_column();
+
+            T v = T();
+            if (!fetch_conversion<T>::fetch(row_, 0, v))
+                throw null_value_fetch(row_.res_->column_to_name(0));
+
+            c.push_back(boost::move(v));
+        }
+
+        return fetched;
+    }
+
     row row_;
     mutable bool opened_;                                   //!< User have already called begin method
+    bool batched_;                                          //!< Rowset is read by fetch_batch
 };
 
 // -------- rowset_iterator<T> implementation ---------
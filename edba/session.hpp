@@ -4,6 +4,7 @@
 #include <edba/statement.hpp>
 #include <edba/conn_info.hpp>
 #include <edba/driver_manager.hpp>
+#include <edba/notification.hpp>
 
 namespace edba {
 
@@ -226,6 +227,70 @@ public:
         return conn_->connection_info();
     }
 
+    /// Subscribe session to notifications sent to \a channel. Currently supported only by PostgreSQL backend,
+    /// other backends throw not_supported_by_backend.
+    void listen(const string_ref& channel)
+    {
+        if (!conn_)
+            throw empty_session("listen");
+
+        conn_->listen(channel);
+    }
+
+    /// Cancel subscription to notifications sent to \a channel
+    void unlisten(const string_ref& channel)
+    {
+        if (!conn_)
+            throw empty_session("unlisten");
+
+        conn_->unlisten(channel);
+    }
+
+    /// Check for notification without blocking. Return true and store notification in \a n if
+    /// one has been received, otherwise return false.
+    bool poll_notification(notification& n)
+    {
+        if (!conn_)
+            throw empty_session("poll_notification");
+
+        return conn_->wait_notification(n, 0);
+    }
+
+    /// Wait for notification at most \a timeout_ms milliseconds, negative value means wait infinitely.
+    /// Return true and store notification in \a n if one has been received, return false on timeout.
+    bool wait_notification(notification& n, int timeout_ms = -1)
+    {
+        if (!conn_)
+            throw empty_session("wait_notification");
+
+        return conn_->wait_notification(n, timeout_ms);
+    }
+
+    /// Return socket descriptor of the connection for integration with external reactor, or -1 if backend
+    /// doesn`t communicate with server through socket (sqlite3) or doesn`t expose it (odbc, oracle).
+    int native_socket()
+    {
+        if (!conn_)
+            throw empty_session("native_socket");
+
+        return conn_->native_socket();
+    }
+
+    /// Return backend specific extension \a Extension, for example edba::sqlite3::extension.
+    /// Throw not_supported_by_backend if backend of this session doesn`t provide it.
+    template<typename Extension>
+    Extension extension()
+    {
+        if (!conn_)
+            throw empty_session("extension");
+
+        void* ext = conn_->get_extension(Extension::extension_name());
+        if (!ext)
+            throw not_supported_by_backend(std::string("edba::session: extension ") + Extension::extension_name() + " is not supported by " + conn_->backend());
+
+        return Extension(conn_, *static_cast<typename Extension::iface_type*>(ext));
+    }
+
     /// Equality operator
     friend bool operator==(const session& s1, const session& s2)
     {
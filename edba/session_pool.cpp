@@ -1,5 +1,8 @@
 #include <edba/session_pool.hpp>
 #include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+
+#include <algorithm>
 
 namespace edba {
 
@@ -14,6 +17,12 @@ struct session_pool::connection_proxy : backend::connection_iface
     
     ~connection_proxy()
     {
+        // Don`t pass subscriptions to the next owner of connection
+        BOOST_FOREACH(const std::string& channel, channels_)
+        {
+            try { conn_->unlisten(channel); } catch(...) {}
+        }
+
         mutex::scoped_lock g(pool_.pool_guard_);
         pool_.total_sec_ += conn_->total_execution_time() - exec_time_on_init_;
         pool_.pool_.push_back(conn_);
@@ -95,10 +104,38 @@ struct session_pool::connection_proxy : backend::connection_iface
         return conn_->connection_info();
     }
 
+    virtual void listen(const string_ref& channel)
+    {
+        conn_->listen(channel);
+        channels_.push_back(std::string(channel.begin(), channel.end()));
+    }
+
+    virtual void unlisten(const string_ref& channel)
+    {
+        conn_->unlisten(channel);
+        channels_.erase(std::remove(channels_.begin(), channels_.end(), channel), channels_.end());
+    }
+
+    virtual bool wait_notification(notification& n, int timeout_ms)
+    {
+        return conn_->wait_notification(n, timeout_ms);
+    }
+
+    virtual int native_socket()
+    {
+        return conn_->native_socket();
+    }
+
+    virtual void* get_extension(const string_ref& name)
+    {
+        return conn_->get_extension(name);
+    }
+
 private:
     session_pool& pool_;
     backend::connection_ptr conn_;
     double exec_time_on_init_;
+    std::vector<std::string> channels_;
 };
 
 session_pool::session_pool(const char* conn_string, int max_pool_size, session_monitor* sm)
@@ -0,0 +1,887 @@
+#ifndef EDBA_SQLITE3_HPP
+#define EDBA_SQLITE3_HPP
+
+#include <edba/statement.hpp>
+#include <edba/errors.hpp>
+#include <edba/detail/index_sequence.hpp>
+
+#include <boost/config.hpp>
+#include <boost/function.hpp>
+#include <boost/mpl/assert.hpp>
+#include <boost/optional/optional_fwd.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/range/begin.hpp>
+#include <boost/range/end.hpp>
+#include <boost/range/value_type.hpp>
+#include <boost/range/const_iterator.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_floating_point.hpp>
+#include <boost/type_traits/remove_cv.hpp>
+#include <boost/type_traits/remove_reference.hpp>
+#include <boost/utility/enable_if.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <ctime>
+
+#ifndef BOOST_NO_CXX11_HDR_CHRONO
+#include <chrono>
+#endif
+
+#ifndef BOOST_NO_CXX11_VARIADIC_TEMPLATES
+#include <tuple>
+#endif
+
+namespace boost {
+namespace gregorian { class date; }
+namespace posix_time { class ptime; }
+}
+
+namespace edba { namespace sqlite3 {
+
+///
+/// \brief Handle to a single BLOB value opened for incremental I/O, see sqlite3_blob_open.
+///
+/// Blob size is fixed when value is written, use zeroblob(N) SQL function to reserve space
+/// before writing content incrementally. Handle keeps connection alive.
+///
+struct blob_iface
+{
+    virtual ~blob_iface() {}
+
+    ///
+    /// Return size of blob in bytes
+    ///
+    virtual std::size_t size() = 0;
+    ///
+    /// Read \a n bytes starting at \a offset into \a buf. Throw edba_error if range exceeds blob size.
+    ///
+    virtual void read(std::size_t offset, void* buf, std::size_t n) = 0;
+    ///
+    /// Write \a n bytes from \a buf starting at \a offset. Throw edba_error if range exceeds blob size
+    /// or blob was opened readonly.
+    ///
+    virtual void write(std::size_t offset, const void* buf, std::size_t n) = 0;
+    ///
+    /// Point handle to the blob in the same table and column of row \a rowid, faster than opening new handle
+    ///
+    virtual void reopen(long long rowid) = 0;
+};
+
+typedef boost::shared_ptr<blob_iface> blob_ptr;
+
+///
+/// \brief Online backup of database in progress, see sqlite3_backup_init.
+///
+/// Source database is locked only while step is running, writers may proceed between steps. If source is modified
+/// by other connection, backup restarts on next step. Handle keeps source and destination connections alive.
+///
+struct backup_iface
+{
+    virtual ~backup_iface() {}
+
+    ///
+    /// Copy up to \a pages pages, negative value copies all remaining pages. Return true when backup is complete,
+    /// false if there are more pages to copy or source is busy. Throw edba_error on other errors.
+    ///
+    virtual bool step(int pages) = 0;
+    ///
+    /// Return number of pages left to copy, as of the last step
+    ///
+    virtual int remaining() = 0;
+    ///
+    /// Return total number of pages in source database, as of the last step
+    ///
+    virtual int page_count() = 0;
+};
+
+typedef boost::shared_ptr<backup_iface> backup_ptr;
+
+///
+/// \brief Arguments and result of user defined function call.
+///
+/// Arguments are fetched through fetch_conversion and result is set through bind_conversion, so any type that
+/// can be fetched from row and bound to statement is supported. Result is NULL unless it is set.
+///
+class function_context
+{
+public:
+    ///
+    /// Return number of arguments
+    ///
+    virtual int args() = 0;
+    ///
+    /// Return true if argument \a arg is NULL
+    ///
+    virtual bool is_null(int arg) = 0;
+
+    ///
+    /// Fetch argument \a arg into \a v, return false and leave \a v untouched if argument is NULL
+    ///
+    template<typename T>
+    bool fetch(int arg, T& v)
+    {
+        arguments args(*this);
+        return fetch_conversion<T>::fetch(row(backend::connection_ptr(), backend::statement_ptr(), backend::result_ptr(&args)), arg, v);
+    }
+
+    ///
+    /// Return argument \a arg, throw null_value_fetch if it is NULL
+    ///
+    template<typename T>
+    T get(int arg)
+    {
+        T v;
+        if (!fetch(arg, v))
+            throw null_value_fetch("argument " + boost::lexical_cast<std::string>(arg));
+
+        return v;
+    }
+
+    ///
+    /// Set result of function call
+    ///
+    template<typename T>
+    void result(const T& v)
+    {
+        result_setter setter(*this);
+        statement st((backend::connection_ptr()), backend::statement_ptr(&setter));
+        bind_conversion<T>::template bind(st, 1, v);
+    }
+
+protected:
+    ~function_context() {}
+
+    virtual bool fetch_impl(int arg, const fetch_types_variant& v) = 0;
+    virtual void result_impl(const bind_types_variant& v) = 0;
+
+private:
+    // Arguments seen as a row and result seen as a statement with single placeholder, so that conversions
+    // of user types apply. Adapters live on stack, extra reference keeps intrusive_ptr from deleting them.
+
+    class arguments : public backend::result_iface
+    {
+    public:
+        explicit arguments(function_context& ctx) : ctx_(ctx) { add_ref(); }
+
+        virtual next_row has_next() { return last_row_reached; }
+        virtual bool next() { return false; }
+        virtual bool fetch(int col, const fetch_types_variant& v) { return ctx_.fetch_impl(col, v); }
+        virtual std::size_t fetch_batch(std::size_t, std::vector<column_buffer>&) { unsupported(); return 0; }
+        virtual bool is_null(int col) { return ctx_.is_null(col); }
+        virtual int cols() { return ctx_.args(); }
+        virtual boost::uint64_t rows() { return 1; }
+        virtual int name_to_column(const string_ref&) { return -1; }
+        virtual std::string column_to_name(int col) { throw invalid_column(col); }
+
+    private:
+        function_context& ctx_;
+    };
+
+    class result_setter : public backend::statement_iface
+    {
+    public:
+        explicit result_setter(function_context& ctx) : ctx_(ctx) { add_ref(); }
+
+        virtual void bind(int, const bind_types_variant& val) { ctx_.result_impl(val); }
+        virtual void bind(const string_ref&, const bind_types_variant& val) { ctx_.result_impl(val); }
+        virtual void reset_bindings() {}
+        virtual const std::string& patched_query() const { static const std::string empty; return empty; }
+        virtual backend::result_ptr run_query() { unsupported(); return backend::result_ptr(); }
+        virtual void run_exec() { unsupported(); }
+        virtual long long sequence_last(std::string const&) { unsupported(); return 0; }
+        virtual unsigned long long affected() { unsupported(); return 0; }
+        virtual void async_start(bool, const boost::function<void()>&) { unsupported(); }
+        virtual bool async_wait(int) { unsupported(); return false; }
+        virtual bool async_wants_write() { return false; }
+        virtual backend::result_ptr async_query_result() { unsupported(); return backend::result_ptr(); }
+        virtual void async_exec_result() { unsupported(); }
+
+    private:
+        function_context& ctx_;
+    };
+
+    static void unsupported()
+    {
+        throw not_supported_by_backend("edba::sqlite3::function_context: operation is not supported for function result");
+    }
+};
+
+typedef boost::function<void(function_context&)> scalar_function;
+
+namespace detail {
+
+template<typename T>
+struct function_arg
+{
+    typedef typename boost::remove_cv<typename boost::remove_reference<T>::type>::type type;
+};
+
+#ifndef BOOST_NO_CXX11_VARIADIC_TEMPLATES
+
+// Adapter of plain function to scalar_function, NULL argument leaves result NULL
+template<typename Signature>
+struct function_adapter;
+
+template<typename R, typename... A>
+struct function_adapter<R(A...)>
+{
+    static const int arity = sizeof...(A);
+
+    explicit function_adapter(R (*f)(A...)) : f_(f) {}
+
+    void operator()(function_context& ctx) const
+    {
+        call(ctx, typename edba::detail::make_index_sequence<sizeof...(A)>::type());
+    }
+
+    R (*f_)(A...);
+
+private:
+    template<std::size_t... I>
+    void call(function_context& ctx, edba::detail::index_sequence<I...>) const
+    {
+        std::tuple<typename function_arg<A>::type...> args;
+        bool fetched = true;
+        (void)edba::detail::expand_pack{0, ((void)(fetched = fetched && ctx.fetch(int(I), std::get<I>(args))), 0)...};
+        if (fetched)
+            ctx.result(f_(std::get<I>(args)...));
+    }
+};
+
+#endif // BOOST_NO_CXX11_VARIADIC_TEMPLATES
+
+} // namespace detail
+
+///
+/// \brief State of aggregate or window function for a single group of rows.
+///
+struct aggregate_iface
+{
+    virtual ~aggregate_iface() {}
+
+    ///
+    /// Add row with arguments from \a ctx to the group
+    ///
+    virtual void step(function_context& ctx) = 0;
+    ///
+    /// Set current result of the group in \a ctx. Called once for aggregate and after each row for window function.
+    ///
+    virtual void value(function_context& ctx) = 0;
+    ///
+    /// Remove row with arguments from \a ctx that left window frame, called only for window functions
+    ///
+    virtual void inverse(function_context&)
+    {
+        throw edba_error("edba::sqlite3::aggregate_iface: inverse is not implemented by aggregate");
+    }
+};
+
+///
+/// Create state for new group of rows
+///
+typedef boost::function<aggregate_iface*()> aggregate_factory;
+
+///
+/// \brief Factory that creates aggregate state of type T with default constructor
+///
+template<typename T>
+struct default_aggregate_factory
+{
+    aggregate_iface* operator()() const
+    {
+        return new T;
+    }
+};
+
+///
+/// \brief Constraint of query on virtual table column, see sqlite3_index_info.
+///
+struct index_constraint
+{
+    /// Values of op for common operators, other sqlite operator codes may be passed too
+    enum { eq = 2, gt = 4, le = 8, lt = 16, ge = 32 };
+
+    int column;         ///< Constrained column, -1 for rowid
+    int op;             ///< Constraint operator
+    bool usable;        ///< Constraint can be used by plan
+    int argv_index;     ///< Set to 1-based position of constraint value among filter arguments to use it
+    bool omit;          ///< Set to true if cursor fully checks constraint, so engine may skip the check
+};
+
+///
+/// \brief Query plan of virtual table, filled by vtab_iface::best_index.
+///
+struct index_info
+{
+    index_info() : idx_num(0), estimated_cost(1e6), estimated_rows(1000000) {}
+
+    std::vector<index_constraint> constraints;
+    int idx_num;                ///< Passed to vtab_cursor_iface::filter to identify chosen plan
+    double estimated_cost;      ///< Cost of the plan, engine chooses the cheapest one
+    long long estimated_rows;   ///< Number of rows returned by the plan
+};
+
+///
+/// \brief Iteration over rows of virtual table.
+///
+struct vtab_cursor_iface
+{
+    virtual ~vtab_cursor_iface() {}
+
+    ///
+    /// Start iteration with plan \a idx_num chosen by best_index. Values of constraints with argv_index set
+    /// are passed as arguments of \a args.
+    ///
+    virtual void filter(int idx_num, function_context& args) = 0;
+    ///
+    /// Return true if there are no more rows
+    ///
+    virtual bool eof() = 0;
+    ///
+    /// Move to the next row
+    ///
+    virtual void next() = 0;
+    ///
+    /// Set value of column \a col of current row as result of \a ctx
+    ///
+    virtual void column(int col, function_context& ctx) = 0;
+    ///
+    /// Return unique id of current row
+    ///
+    virtual long long rowid() = 0;
+};
+
+///
+/// \brief Read only table provided by application, see extension::create_virtual_table.
+///
+struct vtab_iface
+{
+    virtual ~vtab_iface() {}
+
+    ///
+    /// Return CREATE TABLE statement that declares columns, table name in it is ignored
+    ///
+    virtual std::string schema() = 0;
+    ///
+    /// Choose plan for query constraints. Default implementation scans all rows.
+    ///
+    virtual void best_index(index_info&) {}
+    ///
+    /// Return new cursor, it is owned by caller
+    ///
+    virtual vtab_cursor_iface* open() = 0;
+};
+
+typedef boost::shared_ptr<vtab_iface> vtab_ptr;
+
+///
+/// \brief SQL type name of column holding values of type T.
+///
+/// Specialize it for user types that have bind_conversion, or pass type name to range_table::column explicitly.
+///
+template<typename T, typename Enable = void>
+struct vtab_column_type
+{
+    BOOST_MPL_ASSERT_MSG(false, ADD_SPECIALIZATION_OF_VTAB_COLUMN_TYPE_FOR_TYPE, (T));
+};
+
+template<typename T>
+struct vtab_column_type<T, typename boost::enable_if< boost::is_integral<T> >::type>
+{
+    static const char* name() { return "integer"; }
+};
+
+template<typename T>
+struct vtab_column_type<T, typename boost::enable_if< boost::is_floating_point<T> >::type>
+{
+    static const char* name() { return "real"; }
+};
+
+template<>
+struct vtab_column_type<std::string, void>
+{
+    static const char* name() { return "text"; }
+};
+
+template<>
+struct vtab_column_type<string_ref, void>
+{
+    static const char* name() { return "text"; }
+};
+
+template<>
+struct vtab_column_type<std::vector<unsigned char>, void>
+{
+    static const char* name() { return "blob"; }
+};
+
+template<>
+struct vtab_column_type<std::tm, void>
+{
+    static const char* name() { return "text"; }
+};
+
+template<>
+struct vtab_column_type<timestamp, void>
+{
+    static const char* name() { return "text"; }
+};
+
+template<>
+struct vtab_column_type<boost::gregorian::date, void>
+{
+    static const char* name() { return "text"; }
+};
+
+template<>
+struct vtab_column_type<boost::posix_time::ptime, void>
+{
+    static const char* name() { return "text"; }
+};
+
+#ifndef BOOST_NO_CXX11_HDR_CHRONO
+template<typename Duration>
+struct vtab_column_type<std::chrono::time_point<std::chrono::system_clock, Duration>, void>
+{
+    static const char* name() { return "text"; }
+};
+#endif
+
+// NULL is stored for empty optional, column has type of contained value
+template<typename T>
+struct vtab_column_type<boost::optional<T>, void> : vtab_column_type<T>
+{
+};
+
+///
+/// \brief Virtual table over elements of C++ range, columns are members or functions of element.
+///
+/// Range is referenced, not copied, and must stay alive and unchanged while table is used. Rowid is position
+/// of element in range. Rows are scanned sequentially, engine applies query constraints.
+///
+/// \code
+/// std::vector<person> people;
+/// boost::shared_ptr< edba::sqlite3::range_table< std::vector<person> > > table = edba::sqlite3::make_range_table(people);
+/// table->column("id", &person::id).column("name", &person::name);
+/// ext.create_virtual_table("people", table);
+/// \endcode
+///
+template<typename Range>
+class range_table : public vtab_iface
+{
+public:
+    typedef typename boost::range_value<Range>::type value_type;
+    typedef typename boost::range_const_iterator<Range>::type iterator;
+    typedef boost::function<void(const value_type&, function_context&)> getter;
+
+    explicit range_table(const Range& range) : range_(range) {}
+
+    ///
+    /// Add column \a name with value of member \a m
+    ///
+    template<typename T>
+    range_table& column(const std::string& name, T value_type::* m)
+    {
+        return column(name, vtab_column_type<T>::name(), member_getter<T>(m));
+    }
+
+    ///
+    /// Add column \a name of SQL type \a type, value is set to context by \a g
+    ///
+    range_table& column(const std::string& name, const std::string& type, const getter& g)
+    {
+        columns_.push_back(quote_identifier(name) + " " + type);
+        getters_.push_back(g);
+        return *this;
+    }
+
+    virtual std::string schema()
+    {
+        std::string result = "create table x(";
+        for (std::size_t i = 0; i < columns_.size(); ++i)
+        {
+            if (i)
+                result += ", ";
+            result += columns_[i];
+        }
+        return result + ")";
+    }
+
+    virtual vtab_cursor_iface* open()
+    {
+        return new cursor(*this);
+    }
+
+private:
+    static std::string quote_identifier(const std::string& name)
+    {
+        std::string result = "\"";
+        for (std::string::const_iterator i = name.begin(); i != name.end(); ++i)
+        {
+            if (*i == '"')
+                result += '"';
+            result += *i;
+        }
+        return result + "\"";
+    }
+
+    template<typename T>
+    struct member_getter
+    {
+        member_getter(T value_type::* m) : m_(m) {}
+
+        void operator()(const value_type& v, function_context& ctx) const
+        {
+            ctx.result(v.*m_);
+        }
+
+        T value_type::* m_;
+    };
+
+    class cursor : public vtab_cursor_iface
+    {
+    public:
+        explicit cursor(range_table& table) : table_(table), rowid_(0) {}
+
+        virtual void filter(int, function_context&)
+        {
+            it_ = boost::begin(table_.range_);
+            rowid_ = 0;
+        }
+
+        virtual bool eof()
+        {
+            return it_ == boost::end(table_.range_);
+        }
+
+        virtual void next()
+        {
+            ++it_;
+            ++rowid_;
+        }
+
+        virtual void column(int col, function_context& ctx)
+        {
+            table_.getters_.at(col)(*it_, ctx);
+        }
+
+        virtual long long rowid()
+        {
+            return rowid_;
+        }
+
+    private:
+        range_table& table_;
+        iterator it_;
+        long long rowid_;
+    };
+
+    const Range& range_;
+    std::vector<std::string> columns_;
+    std::vector<getter> getters_;
+};
+
+///
+/// Return virtual table over \a range, see range_table
+///
+template<typename Range>
+boost::shared_ptr< range_table<Range> > make_range_table(const Range& range)
+{
+    return boost::shared_ptr< range_table<Range> >(new range_table<Range>(range));
+}
+
+///
+/// \brief Interface of SQLite3 connection used by extension.
+///
+/// \a owner is connection handle of session that extension was obtained from. Blob and backup keep it alive,
+/// so connection of pooled session isn`t returned to pool while they use it.
+///
+struct extension_iface
+{
+    virtual blob_ptr open_blob(const backend::connection_ptr& owner, const string_ref& table, const string_ref& column, long long rowid, bool writable) = 0;
+    virtual backup_ptr start_backup(const backend::connection_ptr& owner, extension_iface& destination, const backend::connection_ptr& destination_owner) = 0;
+    virtual backup_ptr start_backup(const backend::connection_ptr& owner, const string_ref& file) = 0;
+
+    virtual std::vector<unsigned char> serialize() = 0;
+    virtual void deserialize(const blob_ref& data, bool readonly) = 0;
+
+    virtual void create_function(const string_ref& name, int nargs, const scalar_function& f, bool deterministic) = 0;
+    virtual void create_aggregate(const string_ref& name, int nargs, const aggregate_factory& factory) = 0;
+    virtual void create_window_function(const string_ref& name, int nargs, const aggregate_factory& factory) = 0;
+    virtual void create_virtual_table(const string_ref& name, const vtab_ptr& table) = 0;
+
+protected:
+    ~extension_iface() {}
+};
+
+///
+/// \brief SQLite3 specific features of connection.
+///
+/// Obtained with session::extension<edba::sqlite3::extension>(), other backends throw not_supported_by_backend.
+/// Handle keeps connection of session alive.
+///
+class extension
+{
+public:
+    typedef extension_iface iface_type;
+
+    static const char* extension_name() { return "sqlite3"; }
+
+    extension(const backend::connection_ptr& owner, extension_iface& impl) : owner_(owner), impl_(&impl) {}
+
+    ///
+    /// Open blob stored in \a column of row \a rowid in \a table of main database for incremental I/O.
+    /// Blob and backup keep connection of session alive, pooled connection returns to pool after they are released.
+    ///
+    blob_ptr open_blob(const string_ref& table, const string_ref& column, long long rowid, bool writable)
+    {
+        return impl_->open_blob(owner_, table, column, rowid, writable);
+    }
+
+    ///
+    /// Start backup of main database of this connection to main database of \a destination connection
+    ///
+    backup_ptr start_backup(const extension& destination)
+    {
+        return impl_->start_backup(owner_, *destination.impl_, destination.owner_);
+    }
+    ///
+    /// Start backup of main database of this connection to database \a file, its content is replaced.
+    /// \a file is parsed as URI only if this connection was opened with uri=on
+    ///
+    backup_ptr start_backup(const string_ref& file)
+    {
+        return impl_->start_backup(owner_, file);
+    }
+
+    ///
+    /// Return copy of main database as it would be written to disk, see sqlite3_serialize
+    ///
+    std::vector<unsigned char> serialize()
+    {
+        return impl_->serialize();
+    }
+    ///
+    /// Replace main database of this connection with in-memory copy of serialized \a data, see sqlite3_deserialize.
+    ///
+    void deserialize(const blob_ref& data, bool readonly)
+    {
+        impl_->deserialize(data, readonly);
+    }
+
+    ///
+    /// Register \a f as SQL function \a name taking \a nargs arguments, negative value means any number of
+    /// arguments. Deterministic functions may be used in indexes and are optimized by query planner.
+    /// Exception thrown by \a f fails the query with exception message.
+    ///
+    void create_function(const string_ref& name, int nargs, const scalar_function& f, bool deterministic)
+    {
+        impl_->create_function(name, nargs, f, deterministic);
+    }
+
+#ifndef BOOST_NO_CXX11_VARIADIC_TEMPLATES
+    ///
+    /// Register plain function \a f as SQL function \a name. Number and types of arguments
+    /// and type of result are taken from signature of \a f. If any argument is NULL, \a f isn`t called and result
+    /// is NULL, boost::optional argument receives NULL instead.
+    ///
+    template<typename Signature>
+    void create_function(const string_ref& name, Signature* f, bool deterministic)
+    {
+        create_function(name, detail::function_adapter<Signature>::arity, detail::function_adapter<Signature>(f), deterministic);
+    }
+#endif
+
+    ///
+    /// Register aggregate function \a name, \a factory creates state for each group of rows
+    ///
+    void create_aggregate(const string_ref& name, int nargs, const aggregate_factory& factory)
+    {
+        impl_->create_aggregate(name, nargs, factory);
+    }
+    ///
+    /// Register aggregate window function \a name, state created by \a factory must implement aggregate_iface::inverse.
+    /// Throw not_supported_by_backend if sqlite is older than 3.25.
+    ///
+    void create_window_function(const string_ref& name, int nargs, const aggregate_factory& factory)
+    {
+        impl_->create_window_function(name, nargs, factory);
+    }
+
+    ///
+    /// Register \a table as read only virtual table \a name, that can be used in queries of this connection
+    /// like ordinary table without CREATE VIRTUAL TABLE statement.
+    ///
+    void create_virtual_table(const string_ref& name, const vtab_ptr& table)
+    {
+        impl_->create_virtual_table(name, table);
+    }
+
+private:
+    backend::connection_ptr owner_;
+    extension_iface* impl_;
+};
+
+///
+/// Run \a backup to completion copying \a pages_per_step pages at a time. \a progress, if not empty, is called
+/// after each step with number of remaining and total pages. Exception thrown from \a progress cancels backup.
+///
+inline void run_backup(
+    backup_iface& backup
+  , int pages_per_step = 100
+  , const boost::function<void(int remaining, int page_count)>& progress = boost::function<void(int, int)>()
+  )
+{
+    for (;;)
+    {
+        bool done = backup.step(pages_per_step);
+        if (progress)
+            progress(backup.remaining(), backup.page_count());
+        if (done)
+            break;
+    }
+}
+
+///
+/// \brief Stream buffer that reads and writes blob in chunks, so values of any size are processed in constant memory.
+///
+/// Supports seeking, but can`t change blob size. Writing past the end of blob fails.
+///
+class blob_streambuf : public std::streambuf
+{
+public:
+    explicit blob_streambuf(const blob_ptr& blob, std::size_t buffer_size = 64 * 1024)
+      : blob_(blob)
+      , size_(blob->size())
+      , buf_((std::max)(buffer_size, std::size_t(1)))
+      , offset_(0)
+    {
+    }
+
+    ~blob_streambuf()
+    {
+        try { flush(); } catch(...) {}
+    }
+
+protected:
+    virtual int_type underflow()
+    {
+        if (gptr() < egptr())
+            return traits_type::to_int_type(*gptr());
+
+        flush();
+
+        std::size_t n = (std::min)(buf_.size(), size_ - offset_);
+        if (!n)
+            return traits_type::eof();
+
+        blob_->read(offset_, &buf_[0], n);
+        setg(&buf_[0], &buf_[0], &buf_[0] + n);
+        return traits_type::to_int_type(*gptr());
+    }
+
+    virtual int_type overflow(int_type c)
+    {
+        flush();
+
+        std::size_t n = (std::min)(buf_.size(), size_ - offset_);
+        if (!n)
+            return traits_type::eof();
+
+        setp(&buf_[0], &buf_[0] + n);
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+
+        return traits_type::not_eof(c);
+    }
+
+    virtual int sync()
+    {
+        flush();
+        return 0;
+    }
+
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode)
+    {
+        flush();
+
+        off_type base = dir == std::ios_base::beg ? 0 : dir == std::ios_base::end ? off_type(size_) : off_type(offset_);
+        off_type target = base + off;
+        if (target < 0 || target > off_type(size_))
+            return pos_type(off_type(-1));
+
+        offset_ = std::size_t(target);
+        return pos_type(target);
+    }
+
+    virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which)
+    {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+
+private:
+    // Write pending output and drop buffered input, offset_ becomes current position.
+    // Errors are reported by exceptions that stream converts to badbit
+    void flush()
+    {
+        if (pbase() && pptr() > pbase())
+        {
+            std::size_t n = std::size_t(pptr() - pbase());
+            setp(0, 0);
+            blob_->write(offset_, &buf_[0], n);
+            offset_ += n;
+        }
+        else if (pbase())
+        {
+            setp(0, 0);
+        }
+
+        if (eback())
+        {
+            offset_ += std::size_t(gptr() - eback());
+            setg(0, 0, 0);
+        }
+    }
+
+    blob_ptr blob_;
+    std::size_t size_;
+    std::vector<char> buf_;
+    std::size_t offset_;    // blob offset of the buffer start
+};
+
+///
+/// \brief Input and output stream over blob, see blob_streambuf.
+///
+/// Example:
+/// \code
+/// sess.once() << "insert into files(data) values(zeroblob(:size))" << size << exec;
+/// edba::sqlite3::blob_stream out(ext.open_blob("files", "data", rowid, true));
+/// out << file.rdbuf();
+/// \endcode
+///
+class blob_stream : public std::iostream
+{
+public:
+    explicit blob_stream(const blob_ptr& blob, std::size_t buffer_size = 64 * 1024)
+      : std::iostream(0)
+      , buf_(blob, buffer_size)
+    {
+        init(&buf_);
+    }
+
+private:
+    blob_streambuf buf_;
+};
+
+}} // namespace edba, sqlite3
+
+#endif // EDBA_SQLITE3_HPP
@@ -2,6 +2,7 @@
 #define EDBA_STATEMENT_HPP
 
 #include <edba/rowset.hpp>
+#include <edba/async_result.hpp>
 
 #include <boost/type_traits/is_convertible.hpp>
 #include <boost/mpl/not.hpp>
@@ -236,6 +237,36 @@ public:
             stmt_->run_exec();
     }
 
+    /// Start query execution and return immediately. Result is obtained through returned handle.
+    /// \a on_complete is called once query completes, see async_operation for details.
+    ///
+    /// Session must not be used for anything else until query completes.
+    ///
+    /// Throw empty_statement exception for empty statements
+    async_query_result async_query(const boost::function<void()>& on_complete = boost::function<void()>())
+    {
+        if (!stmt_)
+            throw empty_statement("async_query");
+
+        stmt_->async_start(true, on_complete);
+        return async_query_result(conn_, stmt_);
+    }
+
+    /// Start statement execution and return immediately. Completion is tracked through returned handle.
+    /// \a on_complete is called once statement completes, see async_operation for details.
+    ///
+    /// Session must not be used for anything else until statement completes.
+    ///
+    /// Throw empty_statement exception for empty statements
+    async_exec_result async_exec(const boost::function<void()>& on_complete = boost::function<void()>())
+    {
+        if (!stmt_)
+            throw empty_statement("async_exec");
+
+        stmt_->async_start(false, on_complete);
+        return async_exec_result(conn_, stmt_);
+    }
+
     // NOTE: Following overloaded operators are members because in case of free functions they need to accept
     // statement by value or const reference. Otherwise the next statement will be illformed because rvalue ref   
     // can`t be casted to non-const lvalue ref.
@@ -270,6 +301,18 @@ public:
         return manipulator(*this);
     }
 
+    /// Apply manipulator on the statement, same as manipulator(*this).
+    async_query_result operator<<(async_query_result (*manipulator)(statement &st))
+    {
+        return manipulator(*this);
+    }
+
+    /// Apply manipulator on the statement, same as manipulator(*this).
+    async_exec_result operator<<(async_exec_result (*manipulator)(statement &st))
+    {
+        return manipulator(*this);
+    }
+
     /// Used with types produced by use function.
     ///
     /// The call st << use("paramname", val) is same as
@@ -291,6 +334,7 @@ public:
 
 private:
     friend class session;
+    friend class sqlite3::function_context;
 
     statement(const backend::connection_ptr& conn, const backend::statement_ptr& stmt)
       : conn_(conn)
@@ -385,6 +429,34 @@ inline rowset<> query(statement &st)
     return st.query();
 }
 
+///
+/// \brief Manipulator that starts asynchronous query. Used as:
+///
+/// \code
+///  edba::async_query_result r = sql << "SELECT name where uid=?" << id << edba::async_query;
+///  ...
+///  edba::rowset<> rs = r.get();
+/// \endcode
+///
+inline async_query_result async_query(statement &st)
+{
+    return st.async_query();
+}
+
+///
+/// \brief Manipulator that starts asynchronous statement execution. Used as:
+///
+/// \code
+///  edba::async_exec_result r = sql << "delete from test" << edba::async_exec;
+///  ...
+///  r.get();
+/// \endcode
+///
+inline async_exec_result async_exec(statement &st)
+{
+    return st.async_exec();
+}
+
 /// Specialization of bind_conversion for native types
 template<typename T>
 struct bind_conversion<T, typename boost::enable_if< boost::mpl::contains<bind_types, T> >::type>
@@ -415,6 +487,17 @@ struct bind_conversion<
     }
 };
 
+/// Specialization for binary data, bound as BLOB. Use by_ref to bind it without copying
+template<>
+struct bind_conversion<std::vector<unsigned char>, void>
+{
+    template<typename ColOrName>
+    static void bind(statement& st, ColOrName col_or_name, const std::vector<unsigned char>& v)
+    {
+        st.bind(col_or_name, bind_types_variant(blob_ref(v)));
+    }
+};
+
 /// Specialization for types that are convertible to std::istream*
 template<typename T>
 struct bind_conversion<
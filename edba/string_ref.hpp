@@ -23,6 +23,25 @@ public:
     string_ref(const char* b, size_t sz) : boost::iterator_range<const char*>(b, b + sz) {}
 };
 
+///
+/// \brief Text bound without copying, created by by_ref.
+///
+class borrowed_string : public string_ref
+{
+public:
+    borrowed_string() {}
+    explicit borrowed_string(const string_ref& s) : string_ref(s) {}
+};
+
+///
+/// Bind \a s without copying it. Caller guarantees that referenced memory stays valid and unchanged until
+/// statement is executed. Backends that have to convert string anyway bind it as ordinary string.
+///
+inline borrowed_string by_ref(const string_ref& s)
+{
+    return borrowed_string(s);
+}
+
 inline std::size_t hash_value(string_ref const& str)
 {
     return boost::hash_range(str.begin(), str.end());
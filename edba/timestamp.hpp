@@ -0,0 +1,102 @@
+#ifndef EDBA_TIMESTAMP_HPP
+#define EDBA_TIMESTAMP_HPP
+
+#include <edba/detail/utils.hpp>
+
+#include <boost/cstdint.hpp>
+
+#include <string>
+#include <ctime>
+
+namespace edba {
+
+///
+/// \brief Point in time with microsecond precision, stored as number of microseconds since 1970-01-01 00:00:00.
+///
+/// Like std::tm, timestamp doesn`t carry timezone. Unlike std::tm it keeps fractional seconds and is bound and fetched
+/// by backends in native database representation where possible, without formatting and parsing text.
+///
+struct timestamp
+{
+    timestamp() : microseconds(0) {}
+
+    explicit timestamp(boost::int64_t us) : microseconds(us) {}
+
+    ///
+    /// Construct timestamp from broken-down time \a t and microseconds of second \a us.
+    /// Out of range fields of \a t are normalized.
+    ///
+    static timestamp from_tm(const std::tm& t, int us = 0)
+    {
+        boost::int64_t year = boost::int64_t(t.tm_year) + 1900 + t.tm_mon / 12;
+        int mon = t.tm_mon % 12;
+        if (mon < 0)
+        {
+            mon += 12;
+            --year;
+        }
+
+        boost::int64_t days = days_from_civil(year, unsigned(mon + 1), 1) + t.tm_mday - 1;
+        boost::int64_t seconds = days * 86400 + boost::int64_t(t.tm_hour) * 3600 + t.tm_min * 60 + t.tm_sec;
+        return timestamp(seconds * 1000000 + us);
+    }
+
+    ///
+    /// Return broken-down time, fractional part of second is dropped
+    ///
+    std::tm to_tm() const
+    {
+        boost::int64_t seconds = floor_div(microseconds, 1000000);
+        boost::int64_t days = floor_div(seconds, 86400);
+        return make_time(days, int(seconds - days * 86400));
+    }
+
+    ///
+    /// Return fractional part of second in microseconds, in range [0, 999999]
+    ///
+    int fraction() const
+    {
+        return int(microseconds - floor_div(microseconds, 1000000) * 1000000);
+    }
+
+    boost::int64_t microseconds; ///< Microseconds since 1970-01-01 00:00:00
+
+private:
+    static boost::int64_t floor_div(boost::int64_t a, boost::int64_t b)
+    {
+        return a >= 0 ? a / b : -((-a - 1) / b) - 1;
+    }
+};
+
+inline bool operator==(const timestamp& a, const timestamp& b) { return a.microseconds == b.microseconds; }
+inline bool operator!=(const timestamp& a, const timestamp& b) { return a.microseconds != b.microseconds; }
+inline bool operator<(const timestamp& a, const timestamp& b) { return a.microseconds < b.microseconds; }
+inline bool operator>(const timestamp& a, const timestamp& b) { return a.microseconds > b.microseconds; }
+inline bool operator<=(const timestamp& a, const timestamp& b) { return a.microseconds <= b.microseconds; }
+inline bool operator>=(const timestamp& a, const timestamp& b) { return a.microseconds >= b.microseconds; }
+
+///
+/// \brief parse ISO-8601 string with optional fractional seconds as timestamp.
+///
+/// Used by backend implementations;
+///
+inline timestamp parse_timestamp(const string_ref& v)
+{
+    int us;
+    std::tm t = parse_time(v, us);
+    return timestamp::from_tm(t, us);
+}
+
+///
+/// \brief format timestamp as "YYYY-MM-DD hh:mm:ss[.ffffff]" string.
+///
+/// Used by backend implementations;
+///
+inline std::string format_timestamp(const timestamp& v)
+{
+    return format_time(v.to_tm(), v.fraction());
+}
+
+}
+
+#endif // EDBA_TIMESTAMP_HPP
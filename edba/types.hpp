@@ -2,6 +2,8 @@
 #define EDBA_TYPES_HPP
 
 #include <edba/string_ref.hpp>
+#include <edba/blob_ref.hpp>
+#include <edba/timestamp.hpp>
 #include <edba/detail/utils.hpp>
 
 #include <boost/config.hpp>
@@ -13,6 +15,7 @@
 #include <boost/cstdint.hpp>
 
 #include <string>
+#include <vector>
 #include <ctime>
 #include <iosfwd>
 
@@ -67,7 +70,11 @@ typedef boost::mpl::vector<
   , double
   , long double
   , string_ref
+  , borrowed_string
+  , blob_ref
+  , borrowed_blob
   , std::tm
+  , timestamp
   , std::istream*
   > bind_types;
 
@@ -87,7 +94,11 @@ typedef boost::mpl::vector<
   , double*
   , long double*
   , std::string*
+  , string_ref*
+  , std::vector<unsigned char>*
+  , blob_ref*
   , std::tm*
+  , timestamp*
   , std::ostream*
   > fetch_types;
 
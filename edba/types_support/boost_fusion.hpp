@@ -3,8 +3,33 @@
 
 #include <edba/statement.hpp>
 
+#include <boost/version.hpp>
 #include <boost/fusion/support/is_sequence.hpp>
+#include <boost/fusion/support/tag_of.hpp>
 #include <boost/fusion/algorithm/iteration/for_each.hpp>
+#include <boost/fusion/sequence/intrinsic/at_c.hpp>
+#include <boost/fusion/sequence/intrinsic/size.hpp>
+#include <boost/fusion/sequence/intrinsic/value_at.hpp>
+#include <boost/mpl/assert.hpp>
+#include <boost/mpl/contains.hpp>
+#include <boost/mpl/for_each.hpp>
+#include <boost/mpl/or.hpp>
+#include <boost/mpl/range_c.hpp>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/type_traits/is_same.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Member names of structs adapted with BOOST_FUSION_ADAPT_STRUCT are available only through undocumented
+// extension::struct_member_name. Define EDBA_NO_FUSION_MEMBER_NAMES to bind such structs by position
+// if it changes in future Boost versions.
+#if !defined(EDBA_NO_FUSION_MEMBER_NAMES) && BOOST_VERSION >= 105800
+#  include <boost/fusion/adapted/struct/detail/extension.hpp>
+#  define EDBA_FUSION_MEMBER_NAMES
+#endif
 
 namespace edba {
 
@@ -58,6 +83,212 @@ struct fetch_conversion< T, typename boost::enable_if< boost::fusion::traits::is
     }
 };
 
+/// \cond INTERNAL
+namespace detail {
+
+// Element of column vector for sequence member. NULL is reported for plain members and
+// becomes empty value for boost::optional members.
+template<typename M>
+struct batch_member
+{
+    typedef M value_type;
+
+    static bool assign(M& dst, M& src, bool valid)
+    {
+        using std::swap;
+        swap(dst, src);
+        return valid;
+    }
+};
+
+template<typename M>
+struct batch_member< boost::optional<M> >
+{
+    typedef M value_type;
+
+    static bool assign(boost::optional<M>& dst, M& src, bool valid)
+    {
+        using std::swap;
+        if (valid)
+        {
+            dst = M();
+            swap(*dst, src);
+        }
+        else
+            dst = boost::none;
+
+        return true;
+    }
+};
+
+// Column of sequence member, members of adapted structs are bound by name, other sequences by position
+template<typename T, int I, typename Enable = void>
+struct batch_member_column
+{
+    static int resolve(const rowset<>&)
+    {
+        return I;
+    }
+};
+
+#ifdef EDBA_FUSION_MEMBER_NAMES
+
+// The only place that depends on Boost.Fusion internals
+template<typename T, int I>
+struct adapted_member_name
+{
+    static const char* call()
+    {
+        return boost::fusion::extension::struct_member_name<T, I>::call();
+    }
+};
+
+template<typename T, int I>
+struct batch_member_column<
+    T
+  , I
+  , typename boost::enable_if<
+        boost::mpl::or_<
+            boost::is_same<typename boost::fusion::traits::tag_of<T>::type, boost::fusion::struct_tag>
+          , boost::is_same<typename boost::fusion::traits::tag_of<T>::type, boost::fusion::assoc_struct_tag>
+          >
+      >::type
+  >
+{
+    static int resolve(const rowset<>& rs)
+    {
+        return rs.column_index(adapted_member_name<T, I>::call());
+    }
+};
+
+#endif
+
+} // detail
+/// \endcond
+
+///
+/// \brief Read rows of rowset into Boost.Fusion sequences through rowset::fetch_batch.
+///
+/// Columns are bound to members once, when reader is constructed: by explicitly given column names, otherwise
+/// members of structs adapted with BOOST_FUSION_ADAPT_STRUCT by case insensitive member name and members
+/// of other sequences by position.
+/// Every batch is fetched by backend into column vectors and then moved into sequences by routine generated
+/// for \a T, without virtual calls and type conversions per value.
+///
+/// Member types should be element types supported by column_buffer, or boost::optional of them.
+/// NULL value for member that is not optional throws null_value_fetch.
+///
+/// \code
+/// struct employee { int id; std::string name; boost::optional<double> salary; };
+/// BOOST_FUSION_ADAPT_STRUCT(employee, (int, id)(std::string, name)(boost::optional<double>, salary))
+///
+/// edba::batch_reader<employee> reader(sess << "select name, salary, id from employees");
+///
+/// std::vector<employee> batch;
+/// while(reader.fetch(1024, batch))
+///     process(batch);
+/// \endcode
+///
+template<typename T>
+class batch_reader
+{
+    typedef boost::mpl::range_c<int, 0, boost::fusion::result_of::size<T>::value> members;
+
+    struct bind_column
+    {
+        bind_column(batch_reader& r, const std::vector<std::string>* names) : r_(r), names_(names) {}
+
+        template<typename I>
+        void operator()(I) const
+        {
+            typedef typename boost::fusion::result_of::value_at_c<T, I::value>::type member_type;
+            typedef typename detail::batch_member<member_type>::value_type value_type;
+
+            BOOST_MPL_ASSERT_MSG(
+                (boost::mpl::contains<batch_types, std::vector<value_type>*>::value)
+              , MEMBER_TYPE_IS_NOT_SUPPORTED_BY_BATCH_FETCH
+              , (member_type)
+              );
+
+            boost::shared_ptr< std::vector<value_type> > v(new std::vector<value_type>);
+            r_.storage_.push_back(v);
+            int col = names_
+                ? r_.rs_.column_index((*names_)[I::value])
+                : detail::batch_member_column<T, I::value>::resolve(r_.rs_);
+            r_.buffers_.push_back(column_buffer(col, *v));
+        }
+
+        batch_reader& r_;
+        const std::vector<std::string>* names_;
+    };
+
+    struct assign_member
+    {
+        assign_member(batch_reader& r, std::vector<T>& out) : r_(r), out_(out) {}
+
+        template<typename I>
+        void operator()(I) const
+        {
+            typedef typename boost::fusion::result_of::value_at_c<T, I::value>::type member_type;
+            typedef typename detail::batch_member<member_type>::value_type value_type;
+
+            const column_buffer& buf = r_.buffers_[I::value];
+            std::vector<value_type>& values = *boost::get<std::vector<value_type>*>(buf.values);
+
+            for (std::size_t row = 0; row < out_.size(); ++row)
+            {
+                bool valid = !buf.null_count || !buf.is_null(row);
+                if (!detail::batch_member<member_type>::assign(boost::fusion::at_c<I::value>(out_[row]), values[row], valid))
+                    throw null_value_fetch(r_.rs_.column_name(buf.column));
+            }
+        }
+
+        batch_reader& r_;
+        std::vector<T>& out_;
+    };
+
+public:
+    ///
+    /// Bind columns of rowset \a rs to members of \a T. Rowset shouldn`t be iterated by user.
+    /// Throws invalid_column if some member has no corresponding column.
+    ///
+    explicit batch_reader(const rowset<>& rs)
+      : rs_(rs)
+    {
+        boost::mpl::for_each<members>(bind_column(*this, 0));
+    }
+
+    ///
+    /// Bind member i of \a T to column named \a columns[i] of rowset \a rs. Rowset shouldn`t be iterated by user.
+    /// Throws invalid_column if some name has no corresponding column.
+    ///
+    batch_reader(const rowset<>& rs, const std::vector<std::string>& columns)
+      : rs_(rs)
+    {
+        if (columns.size() != std::size_t(boost::fusion::result_of::size<T>::value))
+            throw edba_error("edba::batch_reader: number of column names doesn`t match number of members");
+
+        boost::mpl::for_each<members>(bind_column(*this, &columns));
+    }
+
+    ///
+    /// Replace content of \a out with at most \a n next rows and return number of fetched rows,
+    /// 0 means that no rows remain.
+    ///
+    std::size_t fetch(std::size_t n, std::vector<T>& out)
+    {
+        std::size_t rows = rs_.fetch_batch(n, buffers_);
+        out.resize(rows);
+        boost::mpl::for_each<members>(assign_member(*this, out));
+        return rows;
+    }
+
+private:
+    rowset<> rs_;
+    std::vector<column_buffer> buffers_;
+    std::vector< boost::shared_ptr<void> > storage_;
+};
+
 }             // namespace edba
 
 #endif        // EDBA_TYPES_SUPPORT_BOOST_FUSION_HPP
@@ -1,59 +1,61 @@
-#if !defined(BOOST_PP_IS_ITERATING)
+#ifndef EDBA_TYPES_SUPPORT_BOOST_TUPLE_HPP
+#define EDBA_TYPES_SUPPORT_BOOST_TUPLE_HPP
 
-#  ifndef EDBA_TYPES_SUPPORT_BOOST_TUPLE_HPP
-#  define EDBA_TYPES_SUPPORT_BOOST_TUPLE_HPP
+#include <edba/statement.hpp>
 
-#  include <edba/statement.hpp>
-
-#  include <boost/tuple/tuple.hpp>
-#  include <boost/preprocessor/tuple.hpp>
+#include <boost/tuple/tuple.hpp>
 
 namespace edba {
 
-#  include <boost/preprocessor/iteration/iterate.hpp>
-#  include <boost/preprocessor/iteration/local.hpp>
-#  include <boost/preprocessor/repetition/enum_params.hpp>
+/// \cond INTERNAL
+namespace detail {
+    // boost::tuple is a list of cons cells, elements are processed by walking the list
 
-#  define BOOST_PP_ITERATION_PARAMS_1 (3, (1, 10, "edba/types_support/boost_tuple.hpp"))
-#  include BOOST_PP_ITERATE()
+    inline void bind_tuple_elements(statement&, const boost::tuples::null_type&) {}
 
-}
+    template<typename H, typename T>
+    void bind_tuple_elements(statement& st, const boost::tuples::cons<H, T>& v)
+    {
+        st << v.get_head();
+        bind_tuple_elements(st, v.get_tail());
+    }
 
-#  endif        // EDBA_TYPES_SUPPORT_BOOST_TUPLE_HPP
+    inline void fetch_tuple_elements(const row&, const boost::tuples::null_type&) {}
 
-#else           // !defined(BOOST_PP_IS_ITERATING)
+    template<typename H, typename T>
+    void fetch_tuple_elements(const row& res, boost::tuples::cons<H, T>& v)
+    {
+        res >> v.get_head();
+        fetch_tuple_elements(res, v.get_tail());
+    }
+}
+/// \endcond
 
-template<BOOST_PP_ENUM_PARAMS(BOOST_PP_ITERATION(), typename T)>
-struct bind_conversion< boost::tuple<BOOST_PP_ENUM_PARAMS(BOOST_PP_ITERATION(), T)>, void >
+template<typename T0, typename T1, typename T2, typename T3, typename T4, typename T5, typename T6, typename T7, typename T8, typename T9>
+struct bind_conversion< boost::tuple<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9>, void >
 {
-    typedef boost::tuple<BOOST_PP_ENUM_PARAMS(BOOST_PP_ITERATION(), T)> tuple_type;
+    typedef boost::tuple<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9> tuple_type;
 
     template<typename ColOrName>
     static void bind(statement& st, ColOrName, const tuple_type& v)
     {
-
-#  define BOOST_PP_LOCAL_MACRO(n) st << boost::get<n>(v);
-#  define BOOST_PP_LOCAL_LIMITS (0, BOOST_PP_ITERATION() - 1)
-#  include BOOST_PP_LOCAL_ITERATE()
-
+        detail::bind_tuple_elements(st, v);
     }
 };
 
-template<BOOST_PP_ENUM_PARAMS(BOOST_PP_ITERATION(), typename T)>
-struct fetch_conversion< boost::tuple<BOOST_PP_ENUM_PARAMS(BOOST_PP_ITERATION(), T)>, void >
+template<typename T0, typename T1, typename T2, typename T3, typename T4, typename T5, typename T6, typename T7, typename T8, typename T9>
+struct fetch_conversion< boost::tuple<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9>, void >
 {
-    typedef boost::tuple<BOOST_PP_ENUM_PARAMS(BOOST_PP_ITERATION(), T)> tuple_type;
+    typedef boost::tuple<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9> tuple_type;
 
     template<typename ColOrName>
     static bool fetch(const row& res, ColOrName, tuple_type& v)
     {
-
-#  define BOOST_PP_LOCAL_MACRO(n) res >> boost::get<n>(v);
-#  define BOOST_PP_LOCAL_LIMITS (0, BOOST_PP_ITERATION() - 1)
-#  include BOOST_PP_LOCAL_ITERATE()
-
+        detail::fetch_tuple_elements(res, v);
         return true;
     }
 };
 
-#endif          // !defined(BOOST_PP_IS_ITERATING)
+}
+
+#endif // EDBA_TYPES_SUPPORT_BOOST_TUPLE_HPP
@@ -0,0 +1,44 @@
+#include <boost/config.hpp>
+
+#if !defined(EDBA_TYPES_SUPPORT_STD_CHRONO_HPP) && !defined(BOOST_NO_CXX11_HDR_CHRONO)
+#define EDBA_TYPES_SUPPORT_STD_CHRONO_HPP
+
+#include <edba/statement.hpp>
+
+#include <chrono>
+
+namespace edba
+{
+
+template<typename Duration>
+struct bind_conversion<std::chrono::time_point<std::chrono::system_clock, Duration>, void>
+{
+    template<typename ColOrName>
+    static void bind(statement& st, ColOrName col_or_name, const std::chrono::time_point<std::chrono::system_clock, Duration>& v)
+    {
+        std::chrono::microseconds us = std::chrono::duration_cast<std::chrono::microseconds>(v.time_since_epoch());
+        st.bind(col_or_name, timestamp(us.count()));
+    }
+};
+
+template<typename Duration>
+struct fetch_conversion<std::chrono::time_point<std::chrono::system_clock, Duration>, void>
+{
+    template<typename ColOrName>
+    static bool fetch(const row& res, ColOrName col_or_name, std::chrono::time_point<std::chrono::system_clock, Duration>& v)
+    {
+        timestamp ts;
+        bool ret = res.fetch(col_or_name, ts);
+        if (ret)
+        {
+            std::chrono::microseconds us(ts.microseconds);
+            v = std::chrono::time_point<std::chrono::system_clock, Duration>(std::chrono::duration_cast<Duration>(us));
+        }
+
+        return ret;
+    }
+};
+
+}
+
+#endif // EDBA_TYPES_SUPPORT_STD_CHRONO_HPP
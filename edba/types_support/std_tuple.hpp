@@ -1,60 +1,57 @@
-#if !defined(BOOST_PP_IS_ITERATING)
+#include <boost/config.hpp>
 
-#  include <boost/config.hpp>
+#if !defined(EDBA_TYPES_SUPPORT_STD_TUPLE_HPP) && !defined(BOOST_NO_CXX11_HDR_TUPLE) && !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+#define EDBA_TYPES_SUPPORT_STD_TUPLE_HPP
 
-#  if !defined(EDBA_TYPES_SUPPORT_STD_TUPLE_HPP) && !defined(BOOST_NO_CXX11_HDR_TUPLE)
-#  define EDBA_TYPES_SUPPORT_STD_TUPLE_HPP
+#include <edba/statement.hpp>
+#include <edba/detail/index_sequence.hpp>
 
-#  include <edba/statement.hpp>
-
-#  include <tuple>
+#include <cstddef>
+#include <tuple>
 
 namespace edba {
 
-#  include <boost/preprocessor/iteration/iterate.hpp>
-#  include <boost/preprocessor/iteration/local.hpp>
-#  include <boost/preprocessor/repetition/enum_params.hpp>
-
-#  define BOOST_PP_ITERATION_PARAMS_1 (3, (1, 5, "edba/types_support/std_tuple.hpp"))
-#  include BOOST_PP_ITERATE()
-
-}
-
-#  endif        // EDBA_TYPES_SUPPORT_STD_TUPLE_HPP
-
-#else           // !defined(BOOST_PP_IS_ITERATING)
-
-template<BOOST_PP_ENUM_PARAMS(BOOST_PP_ITERATION(), typename T)>
-struct bind_conversion< std::tuple<BOOST_PP_ENUM_PARAMS(BOOST_PP_ITERATION(), T)>, void >
+template<typename... T>
+struct bind_conversion< std::tuple<T...>, void >
 {
-    typedef std::tuple<BOOST_PP_ENUM_PARAMS(BOOST_PP_ITERATION(), T)> tuple_type;
+    typedef std::tuple<T...> tuple_type;
 
     template<typename ColOrName>
     static void bind(statement& st, ColOrName, const tuple_type& v)
     {
+        bind_elements(st, v, typename detail::make_index_sequence<sizeof...(T)>::type());
+    }
 
-#  define BOOST_PP_LOCAL_MACRO(n) st << std::get<n>(v);
-#  define BOOST_PP_LOCAL_LIMITS (0, BOOST_PP_ITERATION() - 1)
-#  include BOOST_PP_LOCAL_ITERATE()
-
+private:
+    template<std::size_t... I>
+    static void bind_elements(statement& st, const tuple_type& v, detail::index_sequence<I...>)
+    {
+        (void)v;
+        (void)detail::expand_pack{0, ((void)(st << std::get<I>(v)), 0)...};
     }
 };
 
-template<BOOST_PP_ENUM_PARAMS(BOOST_PP_ITERATION(), typename T)>
-struct fetch_conversion< std::tuple<BOOST_PP_ENUM_PARAMS(BOOST_PP_ITERATION(), T)>, void >
+template<typename... T>
+struct fetch_conversion< std::tuple<T...>, void >
 {
-    typedef std::tuple<BOOST_PP_ENUM_PARAMS(BOOST_PP_ITERATION(), T)> tuple_type;
+    typedef std::tuple<T...> tuple_type;
 
     template<typename ColOrName>
     static bool fetch(const row& res, ColOrName, tuple_type& v)
     {
-
-#  define BOOST_PP_LOCAL_MACRO(n) res >> std::get<n>(v);
-#  define BOOST_PP_LOCAL_LIMITS (0, BOOST_PP_ITERATION() - 1)
-#  include BOOST_PP_LOCAL_ITERATE()
-
+        fetch_elements(res, v, typename detail::make_index_sequence<sizeof...(T)>::type());
         return true;
     }
+
+private:
+    template<std::size_t... I>
+    static void fetch_elements(const row& res, tuple_type& v, detail::index_sequence<I...>)
+    {
+        (void)v;
+        (void)detail::expand_pack{0, ((void)(res >> std::get<I>(v)), 0)...};
+    }
 };
 
-#endif
+}
+
+#endif // EDBA_TYPES_SUPPORT_STD_TUPLE_HPP
@@ -0,0 +1,96 @@
+#include <edba/edba.hpp>
+#include <edba/arrow.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string.h>
+
+using namespace edba;
+
+namespace {
+
+bool is_valid(const ArrowArray* a, int64_t row)
+{
+    const unsigned char* validity = static_cast<const unsigned char*>(a->buffers[0]);
+    return !validity || (validity[row >> 3] & (1 << (row & 7)));
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(ArrowExportSQLite3)
+{
+    session sess("sqlite3:db=test.db");
+
+    sess.once() << "drop table if exists test_arrow" << exec;
+    sess.once() << "create table test_arrow(id integer, val real, txt varchar(20), created datetime)" << exec;
+
+    statement st = sess.prepare_statement("insert into test_arrow(id, val, txt, created) values(:id, :val, :txt, :created)");
+    st << 1 << 1.5 << "one" << "1970-01-02 00:00:01" << exec;
+    st.reset_bindings() << 2 << null << "two" << null << exec;
+    st.reset_bindings() << 3 << 3.5 << null << "2000-03-01 00:00:00" << exec;
+
+    arrow_exporter exporter(sess << "select id, val, txt, created from test_arrow order by id");
+    exporter.column<int>(0).column<double>(1).column<std::tm>(3);
+
+    BOOST_CHECK_THROW(exporter.column<int>(4), invalid_column);
+
+    ArrowSchema schema;
+    exporter.export_schema(&schema);
+
+    BOOST_REQUIRE_EQUAL(schema.n_children, 4);
+    BOOST_CHECK_EQUAL(schema.format, "+s");
+    BOOST_CHECK_EQUAL(schema.children[0]->format, "i");
+    BOOST_CHECK_EQUAL(schema.children[0]->name, "id");
+    BOOST_CHECK_EQUAL(schema.children[1]->format, "g");
+    BOOST_CHECK_EQUAL(schema.children[2]->format, "u");
+    BOOST_CHECK_EQUAL(schema.children[2]->name, "txt");
+    BOOST_CHECK_EQUAL(schema.children[3]->format, "tss:");
+    BOOST_CHECK_EQUAL(schema.children[3]->flags, ARROW_FLAG_NULLABLE);
+
+    // Consumer may move child out and release it separately
+    ArrowSchema moved = *schema.children[1];
+    schema.children[1]->release = 0;
+    schema.release(&schema);
+    BOOST_CHECK(!schema.release);
+    BOOST_CHECK_EQUAL(moved.format, "g");
+    moved.release(&moved);
+
+    ArrowArray batch;
+    BOOST_REQUIRE(exporter.export_batch(2, &batch));
+    BOOST_CHECK_EQUAL(batch.length, 2);
+    BOOST_REQUIRE_EQUAL(batch.n_children, 4);
+
+    const ArrowArray* ids = batch.children[0];
+    BOOST_CHECK_EQUAL(ids->null_count, 0);
+    BOOST_CHECK_EQUAL(static_cast<const int*>(ids->buffers[1])[1], 2);
+
+    const ArrowArray* vals = batch.children[1];
+    BOOST_CHECK_EQUAL(vals->null_count, 1);
+    BOOST_CHECK(is_valid(vals, 0));
+    BOOST_CHECK(!is_valid(vals, 1));
+    BOOST_CHECK_EQUAL(static_cast<const double*>(vals->buffers[1])[0], 1.5);
+
+    const ArrowArray* txts = batch.children[2];
+    const int32_t* offsets = static_cast<const int32_t*>(txts->buffers[1]);
+    const char* chars = static_cast<const char*>(txts->buffers[2]);
+    BOOST_CHECK_EQUAL(txts->n_buffers, 3);
+    BOOST_CHECK_EQUAL(std::string(chars + offsets[0], chars + offsets[1]), "one");
+    BOOST_CHECK_EQUAL(std::string(chars + offsets[1], chars + offsets[2]), "two");
+
+    const ArrowArray* created = batch.children[3];
+    BOOST_CHECK_EQUAL(static_cast<const int64_t*>(created->buffers[1])[0], 86401);
+    BOOST_CHECK(!is_valid(created, 1));
+
+    batch.release(&batch);
+    BOOST_CHECK(!batch.release);
+
+    BOOST_REQUIRE(exporter.export_batch(2, &batch));
+    BOOST_CHECK_EQUAL(batch.length, 1);
+    BOOST_CHECK(!is_valid(batch.children[2], 0));
+    BOOST_CHECK_EQUAL(static_cast<const int64_t*>(batch.children[3]->buffers[1])[0], 951868800);
+    batch.release(&batch);
+
+    BOOST_CHECK(!exporter.export_batch(2, &batch));
+
+    sess.once() << "drop table test_arrow" << exec;
+}
@@ -0,0 +1,122 @@
+#include <edba/edba.hpp>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/bind.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+
+using namespace edba;
+
+namespace {
+
+struct completion_flag
+{
+    completion_flag() : done_(false) {}
+
+    void set()
+    {
+        boost::mutex::scoped_lock g(guard_);
+        done_ = true;
+        cv_.notify_all();
+    }
+
+    void wait()
+    {
+        boost::mutex::scoped_lock g(guard_);
+        while (!done_)
+            cv_.wait(g);
+    }
+
+    boost::mutex guard_;
+    boost::condition_variable cv_;
+    bool done_;
+};
+
+void throw_from_handler()
+{
+    throw std::runtime_error("completion handler failed");
+}
+
+void run_bad_query(session& sess)
+{
+    // Depending on backend error is detected on preparation or during execution
+    async_query_result r = sess.create_statement("select * from no_such_table").async_query();
+    r.get();
+}
+
+void test_async(const char* conn_string)
+{
+    session sess(conn_string);
+
+    sess.once() << "drop table if exists test_async" << exec;
+    sess.once() << "create table test_async(id integer, txt varchar(20))" << exec;
+
+    statement st = sess.prepare_statement("insert into test_async(id, txt) values(:id, :txt)");
+    for (int i = 0; i < 10; ++i)
+    {
+        st.reset_bindings() << i << "text";
+        async_exec_result r = st.async_exec();
+        r.get();
+        BOOST_CHECK_EQUAL(st.affected(), 1u);
+    }
+
+    completion_flag flag;
+    async_query_result q = (sess << "select id, txt from test_async where id >= :id order by id" << 5)
+        .async_query(boost::bind(&completion_flag::set, &flag));
+
+    flag.wait();
+    BOOST_CHECK(q.ready());
+
+    rowset<> rs = q.get();
+    int expected = 5;
+    for (rowset<>::iterator it = rs.begin(); it != rs.end(); ++it, ++expected)
+    {
+        BOOST_CHECK_EQUAL(it->get<int>(0), expected);
+        BOOST_CHECK_EQUAL(it->get<std::string>(1), "text");
+    }
+    BOOST_CHECK_EQUAL(expected, 10);
+
+    BOOST_CHECK_THROW(q.get(), edba_error);
+
+    BOOST_CHECK_THROW(run_bad_query(sess), edba_error);
+
+    // Destroying handle of unfinished operation waits for its completion
+    {
+        async_exec_result unfinished = st.reset_bindings() << 100 << "unfinished" << edba::async_exec;
+    }
+    BOOST_CHECK_EQUAL(sess.create_statement("select count(*) from test_async").first_row().get<int>(0), 11);
+
+    // Statement released during execution is destroyed only after worker, including completion handler, is done with it
+    {
+        completion_flag released;
+        sess.create_statement("insert into test_async(id, txt) values(101, 'released')")
+            .async_exec(boost::bind(&completion_flag::set, &released));
+        BOOST_CHECK(released.done_);
+    }
+
+    // Exception from completion handler is rethrown when result is taken
+    async_query_result counted = sess.create_statement("select count(*) from test_async").async_query(&throw_from_handler);
+    BOOST_CHECK_THROW(counted.get(), std::runtime_error);
+    BOOST_CHECK_EQUAL(sess.create_statement("select count(*) from test_async").first_row().get<int>(0), 12);
+
+    sess.once() << "drop table test_async" << exec;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(AsyncSQLite3)
+{
+    test_async("sqlite3:db=test.db");
+}
+
+BOOST_AUTO_TEST_CASE(AsyncPostgresql)
+{
+    test_async("postgresql:user=postgres; password=1; host=edba-test; port=5432; dbname=test;");
+}
+
+BOOST_AUTO_TEST_CASE(AsyncMySQL)
+{
+    test_async("mysql:host=edba-test;database=edba;user=edba;password=1111;");
+}
@@ -16,6 +16,7 @@
 
 #include <iostream>
 #include <ctime>
+#include <limits>
 
 #define SERVER_IP "edba-test"
 
@@ -348,6 +349,102 @@ void test_transactions_and_cursors(session sess)
 
     BOOST_CHECK_EQUAL(vc, "3");
     BOOST_CHECK_EQUAL(txt, "3");
+
+    // Streamed MySQL result reads one row ahead to reject query that returns several rows
+    if (sess.backend() == "mysql")
+        BOOST_CHECK_THROW(sess << "select id from test1" << first_row, multiple_rows_query);
+}
+
+// Prepared MySQL statements bind parameters and result columns with native types,
+// values should be the same as unprepared statements get in text
+void test_mysql_types(session sess)
+{
+    try {sess.exec_batch("drop table test_types");} catch(...) {}
+    sess.exec_batch(
+        "create table test_types( "
+        "   id integer primary key, "
+        "   i integer, "
+        "   u bigint unsigned, "
+        "   f float, "
+        "   d double, "
+        "   dt_day date, "
+        "   dt datetime, "
+        "   dt_frac datetime(6), "
+        "   txt text "
+        "   ) ");
+
+    std::tm day = parse_time("2013-02-03");
+    std::tm dt = parse_time("2013-02-03 04:05:06");
+    timestamp dt_frac = parse_timestamp("2013-02-03 04:05:06.000789");
+    unsigned long long u_max = (std::numeric_limits<unsigned long long>::max)();
+
+    // Longer than initial buffer of text column in cursor mode, so it is refetched
+    std::string long_txt(1000, 'x');
+
+    sess << "insert into test_types(id, i, u, f, d, dt_day, dt, dt_frac, txt) values(:id, :i, :u, :f, :d, :dt_day, :dt, :dt_frac, :txt)"
+        << 1 << -5 << u_max << 1.5f << 2.25 << day << dt << dt_frac << long_txt
+        << exec
+        << reset
+        << 2 << null << null << null << null << null << null << null << null
+        << exec;
+
+    {
+        row r = sess << "select i, u, f, d, dt_day, dt, dt_frac, txt from test_types where id=:id" << 1 << first_row;
+
+        BOOST_CHECK_EQUAL(r.get<int>("i"), -5);
+        BOOST_CHECK_EQUAL(r.get<long long>("i"), -5);
+        BOOST_CHECK_EQUAL(r.get<double>("i"), -5.0);
+        BOOST_CHECK_THROW(r.get<unsigned int>("i"), bad_value_cast);
+        BOOST_CHECK_THROW(r.get<unsigned short>("i"), bad_value_cast);
+
+        BOOST_CHECK_EQUAL(r.get<unsigned long long>("u"), u_max);
+        BOOST_CHECK_EQUAL(r.get<std::string>("u"), "18446744073709551615");
+        BOOST_CHECK_THROW(r.get<long long>("u"), bad_value_cast);
+        BOOST_CHECK_THROW(r.get<short>("u"), bad_value_cast);
+
+        BOOST_CHECK_EQUAL(r.get<float>("f"), 1.5f);
+        BOOST_CHECK_EQUAL(r.get<double>("f"), 1.5);
+        BOOST_CHECK_EQUAL(r.get<std::string>("f"), "1.5");
+        BOOST_CHECK_EQUAL(r.get<double>("d"), 2.25);
+        BOOST_CHECK_EQUAL(r.get<std::string>("d"), "2.25");
+
+        BOOST_CHECK_EQUAL(r.get<std::string>("dt_day"), "2013-02-03");
+        BOOST_CHECK_EQUAL(r.get<std::string>("dt"), "2013-02-03 04:05:06");
+        BOOST_CHECK_EQUAL(r.get<std::string>("dt_frac"), "2013-02-03 04:05:06.000789");
+        BOOST_CHECK_EQUAL(format_time(r.get<std::tm>("dt")), "2013-02-03 04:05:06");
+        BOOST_CHECK(r.get<timestamp>("dt_frac") == dt_frac);
+
+        BOOST_CHECK_EQUAL(r.get<std::string>("txt"), long_txt);
+    }
+
+    {
+        row r = sess << "select i, u, f, d, dt_day, dt, dt_frac, txt from test_types where id=:id" << 2 << first_row;
+
+        for (int col = 0; col < 8; ++col)
+            BOOST_CHECK(r.is_null(col));
+
+        boost::optional<int> i = 1;
+        r >> i;
+        BOOST_CHECK(!i);
+    }
+
+    // Zero dates are accepted by server in non strict mode, they are fetched as text only
+    {
+        std::string sql_mode;
+        sess << "select @@session.sql_mode" << first_row >> sql_mode;
+        sess.exec_batch("set session sql_mode = ''");
+        sess.exec_batch("insert into test_types(id, dt_day, dt) values(3, '0000-00-00', '2013-02-00 04:05:06')");
+        sess.exec_batch("set session sql_mode = '" + sql_mode + "'");
+
+        row r = sess << "select dt_day, dt from test_types where id=:id" << 3 << first_row;
+
+        BOOST_CHECK_EQUAL(r.get<std::string>("dt_day"), "0000-00-00");
+        BOOST_CHECK_EQUAL(r.get<std::string>("dt"), "2013-02-00 04:05:06");
+        BOOST_CHECK_THROW(r.get<timestamp>("dt_day"), bad_value_cast);
+        BOOST_CHECK_THROW(r.get<std::tm>("dt"), bad_value_cast);
+    }
+
+    sess.exec_batch("drop table test_types");
 }
 
 void test_incorrect_query(session sess)
@@ -520,6 +617,9 @@ void test(const char* conn_string)
         test_escaping(sess);
         test_utf8(sess);
         test_string_truncation(sess);
+
+        if (sess.backend() == "mysql")
+            test_mysql_types(sess);
     }
 }
 
@@ -543,6 +643,16 @@ BOOST_AUTO_TEST_CASE(MySQL)
     test("mysql:host=" SERVER_IP ";database=edba;user=edba;password=1111;");
 }
 
+BOOST_AUTO_TEST_CASE(MySQLStream)
+{
+    test("mysql:host=" SERVER_IP ";database=edba;user=edba;password=1111;@fetch_mode=stream;@prefetch_rows=2;");
+}
+
+BOOST_AUTO_TEST_CASE(MySQLStreamUnprepared)
+{
+    test("mysql:host=" SERVER_IP ";database=edba;user=edba;password=1111;@fetch_mode=stream;@use_prepared=off;");
+}
+
 BOOST_AUTO_TEST_CASE(SQLite3)
 {
     test("sqlite3:db=test.db");
@@ -0,0 +1,282 @@
+#include <edba/edba.hpp>
+#include <edba/types_support/boost_fusion.hpp>
+
+#include <boost/fusion/adapted/struct/adapt_struct.hpp>
+#include <boost/fusion/container/vector.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <list>
+
+using namespace edba;
+
+struct batch_item
+{
+    int id;
+    boost::optional<double> val;
+    std::string txt;
+};
+
+BOOST_FUSION_ADAPT_STRUCT(
+    batch_item
+  , (int, id)
+    (boost::optional<double>, val)
+    (std::string, txt)
+)
+
+namespace {
+
+void test_batch_fetch(const char* conn_string)
+{
+    session sess(conn_string);
+
+    sess.once() << "drop table if exists test_batch" << exec;
+    sess.once() << "create table test_batch(id integer, val float, txt varchar(20))" << exec;
+
+    statement st = sess.prepare_statement("insert into test_batch(id, val, txt) values(:id, :val, :txt)");
+    for (int i = 0; i < 7; ++i)
+    {
+        st.reset_bindings() << i;
+        if (i % 3 == 0)
+            st << null << null;
+        else
+            st << i * 0.5 << boost::lexical_cast<std::string>(i);
+        st << exec;
+    }
+
+    std::vector<int> ids;
+    std::vector<double> vals;
+    std::vector<std::string> txts;
+
+    std::vector<column_buffer> buffers;
+    buffers.push_back(column_buffer(0, ids));
+    buffers.push_back(column_buffer(1, vals));
+    buffers.push_back(column_buffer(2, txts));
+
+    rowset<> rs = sess << "select id, val, txt from test_batch order by id";
+
+    int expected = 0;
+    std::size_t fetched;
+    while ((fetched = rs.fetch_batch(3, buffers)) != 0)
+    {
+        BOOST_REQUIRE_EQUAL(ids.size(), fetched);
+        BOOST_REQUIRE_EQUAL(vals.size(), fetched);
+        BOOST_REQUIRE_EQUAL(txts.size(), fetched);
+        BOOST_CHECK_EQUAL(buffers[1].null_count, buffers[2].null_count);
+
+        for (std::size_t row = 0; row < fetched; ++row, ++expected)
+        {
+            BOOST_CHECK_EQUAL(ids[row], expected);
+            BOOST_CHECK(!buffers[0].is_null(row));
+
+            if (expected % 3 == 0)
+            {
+                BOOST_CHECK(buffers[1].is_null(row));
+                BOOST_CHECK(buffers[2].is_null(row));
+                BOOST_CHECK(txts[row].empty());
+            }
+            else
+            {
+                BOOST_CHECK(!buffers[1].is_null(row));
+                BOOST_CHECK_CLOSE(vals[row], expected * 0.5, 0.0001);
+                BOOST_CHECK_EQUAL(txts[row], boost::lexical_cast<std::string>(expected));
+            }
+        }
+    }
+    BOOST_CHECK_EQUAL(expected, 7);
+    BOOST_CHECK_THROW(rs.begin(), multiple_rowset_traverse);
+
+    buffers.push_back(column_buffer(3, ids));
+    rowset<> invalid = sess << "select id, val, txt from test_batch";
+    BOOST_CHECK_THROW(invalid.fetch_batch(3, buffers), invalid_column);
+
+    sess.once() << "drop table test_batch" << exec;
+}
+
+void test_batch_reader(const char* conn_string)
+{
+    session sess(conn_string);
+
+    sess.once() << "drop table if exists test_batch" << exec;
+    sess.once() << "create table test_batch(id integer, val float, txt varchar(20))" << exec;
+
+    statement st = sess.prepare_statement("insert into test_batch(id, val, txt) values(:id, :val, :txt)");
+    for (int i = 0; i < 7; ++i)
+    {
+        st.reset_bindings() << i;
+        if (i % 3 == 0)
+            st << null;
+        else
+            st << i * 0.5;
+        st << boost::lexical_cast<std::string>(i) << exec;
+    }
+
+#ifdef EDBA_FUSION_MEMBER_NAMES
+    {
+        // Struct members are bound by name regardless of columns order
+        batch_reader<batch_item> reader(sess << "select txt, ID, val from test_batch order by id");
+
+        std::vector<batch_item> items;
+        int expected = 0;
+        while (reader.fetch(3, items))
+        {
+            BOOST_REQUIRE(items.size() <= 3u);
+            for (std::size_t row = 0; row < items.size(); ++row, ++expected)
+            {
+                BOOST_CHECK_EQUAL(items[row].id, expected);
+                BOOST_CHECK_EQUAL(items[row].txt, boost::lexical_cast<std::string>(expected));
+                BOOST_CHECK_EQUAL(!items[row].val, expected % 3 == 0);
+                if (items[row].val)
+                    BOOST_CHECK_CLOSE(*items[row].val, expected * 0.5, 0.0001);
+            }
+        }
+        BOOST_CHECK_EQUAL(expected, 7);
+        BOOST_CHECK(items.empty());
+    }
+#endif
+
+    {
+        // Other sequences are bound by position
+        batch_reader< boost::fusion::vector<int, std::string> > reader(sess << "select id, txt from test_batch order by id");
+
+        std::vector< boost::fusion::vector<int, std::string> > items;
+        BOOST_CHECK_EQUAL(reader.fetch(100, items), 7u);
+        BOOST_CHECK_EQUAL(boost::fusion::at_c<0>(items[6]), 6);
+        BOOST_CHECK_EQUAL(boost::fusion::at_c<1>(items[6]), "6");
+    }
+
+    {
+        // Explicit column names override both
+        std::vector<std::string> names;
+        names.push_back("txt");
+        names.push_back("id");
+        batch_reader< boost::fusion::vector<std::string, int> > reader(sess << "select id, txt from test_batch order by id", names);
+
+        std::vector< boost::fusion::vector<std::string, int> > items;
+        BOOST_CHECK_EQUAL(reader.fetch(100, items), 7u);
+        BOOST_CHECK_EQUAL(boost::fusion::at_c<0>(items[6]), "6");
+        BOOST_CHECK_EQUAL(boost::fusion::at_c<1>(items[6]), 6);
+
+        names.pop_back();
+        BOOST_CHECK_THROW(batch_reader<batch_item>(sess << "select id, txt from test_batch", names), edba_error);
+    }
+
+#ifdef EDBA_FUSION_MEMBER_NAMES
+    BOOST_CHECK_THROW(batch_reader<batch_item>(sess << "select id, txt from test_batch"), invalid_column);
+#endif
+
+    {
+        batch_reader< boost::fusion::vector<int, double> > reader(sess << "select id, val from test_batch order by id");
+
+        std::vector< boost::fusion::vector<int, double> > items;
+        BOOST_CHECK_THROW(reader.fetch(100, items), null_value_fetch);
+    }
+
+    sess.once() << "drop table test_batch" << exec;
+}
+
+void test_fetch_all(const char* conn_string)
+{
+    session sess(conn_string);
+
+    sess.once() << "drop table if exists test_batch" << exec;
+    sess.once() << "create table test_batch(id integer, val float, txt varchar(20))" << exec;
+
+    statement st = sess.prepare_statement("insert into test_batch(id, val, txt) values(:id, :val, :txt)");
+    for (int i = 0; i < 7; ++i)
+    {
+        st.reset_bindings() << i;
+        if (i % 3 == 0)
+            st << null;
+        else
+            st << i * 0.5;
+        st << boost::lexical_cast<std::string>(i) << exec;
+    }
+
+    {
+        // Column types go through fetch_batch
+        rowset<int> rs = sess << "select id from test_batch order by id";
+
+        std::vector<int> ids(1, -1);
+        BOOST_CHECK_EQUAL(rs.fetch_all(ids), 7u);
+        BOOST_REQUIRE_EQUAL(ids.size(), 8u);
+        for (int i = 0; i < 7; ++i)
+            BOOST_CHECK_EQUAL(ids[i + 1], i);
+
+        BOOST_CHECK_EQUAL(rs.fetch_all(ids), 0u);
+        BOOST_CHECK_THROW(rs.begin(), multiple_rowset_traverse);
+    }
+
+    {
+        rowset<std::string> rs = sess << "select txt from test_batch order by id";
+
+        std::vector<std::string> txts;
+        BOOST_CHECK_EQUAL(rs.fetch_n(txts, 3), 3u);
+        BOOST_CHECK_EQUAL(rs.fetch_n(txts, 3), 3u);
+        BOOST_CHECK_EQUAL(rs.fetch_n(txts, 3), 1u);
+        BOOST_CHECK_EQUAL(rs.fetch_n(txts, 3), 0u);
+        BOOST_REQUIRE_EQUAL(txts.size(), 7u);
+        BOOST_CHECK_EQUAL(txts[6], "6");
+    }
+
+    {
+        // Other types are fetched row by row
+        typedef boost::fusion::vector<int, std::string> item;
+        rowset<item> rs = sess << "select id, txt from test_batch order by id";
+
+        std::list<item> items;
+        BOOST_CHECK_EQUAL(rs.fetch_n(items, 2), 2u);
+        BOOST_CHECK_EQUAL(rs.fetch_all(items), 5u);
+        BOOST_REQUIRE_EQUAL(items.size(), 7u);
+        BOOST_CHECK_EQUAL(boost::fusion::at_c<1>(items.back()), "6");
+    }
+
+    {
+        rowset<double> rs = sess << "select val from test_batch order by id";
+
+        std::vector<double> vals;
+        BOOST_CHECK_THROW(rs.fetch_all(vals), null_value_fetch);
+    }
+
+    {
+        rowset<int> rs = sess << "select id from test_batch order by id";
+        rs.begin();
+
+        std::vector<int> ids;
+        BOOST_CHECK_THROW(rs.fetch_all(ids), multiple_rowset_traverse);
+    }
+
+    sess.once() << "drop table test_batch" << exec;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(BatchFetchSQLite3)
+{
+    test_batch_fetch("sqlite3:db=test.db");
+}
+
+BOOST_AUTO_TEST_CASE(BatchFetchPostgresql)
+{
+    test_batch_fetch("postgresql:user=postgres; password=1; host=edba-test; port=5432; dbname=test;");
+}
+
+BOOST_AUTO_TEST_CASE(BatchReaderSQLite3)
+{
+    test_batch_reader("sqlite3:db=test.db");
+}
+
+BOOST_AUTO_TEST_CASE(BatchReaderPostgresql)
+{
+    test_batch_reader("postgresql:user=postgres; password=1; host=edba-test; port=5432; dbname=test;");
+}
+
+BOOST_AUTO_TEST_CASE(FetchAllSQLite3)
+{
+    test_fetch_all("sqlite3:db=test.db");
+}
+
+BOOST_AUTO_TEST_CASE(FetchAllPostgresql)
+{
+    test_fetch_all("postgresql:user=postgres; password=1; host=edba-test; port=5432; dbname=test;");
+}
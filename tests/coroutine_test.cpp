@@ -0,0 +1,176 @@
+#include <edba/edba.hpp>
+#include <edba/coroutine.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#ifdef EDBA_HAS_COROUTINES
+
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+#ifdef _WIN32
+#  include <winsock2.h>
+#  define poll WSAPoll
+#else
+#  include <poll.h>
+#endif
+
+using namespace edba;
+
+namespace {
+
+/// Fire and forget coroutine
+struct task
+{
+    struct promise_type
+    {
+        task get_return_object() { return task(); }
+        std::suspend_never initial_suspend() { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+/// Single threaded event loop that waits for sockets with poll()
+struct test_loop : coro::reactor
+{
+    struct watch
+    {
+        int fd;
+        short events;
+        std::function<void()> cb;
+    };
+
+    void when_readable(int fd, std::function<void()> cb) override
+    {
+        watches_.push_back(watch{fd, POLLIN, std::move(cb)});
+    }
+
+    void when_writable(int fd, std::function<void()> cb) override
+    {
+        watches_.push_back(watch{fd, POLLOUT, std::move(cb)});
+    }
+
+    void post(std::function<void()> cb) override
+    {
+        std::lock_guard<std::mutex> g(guard_);
+        jobs_.push_back(std::move(cb));
+        cv_.notify_one();
+    }
+
+    void run_until(const bool& stop)
+    {
+        while (!stop)
+        {
+            std::deque< std::function<void()> > ready;
+            {
+                std::unique_lock<std::mutex> g(guard_);
+
+                // Jobs are posted from worker threads, so sockets are polled with short timeout
+                if (watches_.empty())
+                    cv_.wait(g, [this] { return !jobs_.empty(); });
+
+                ready.swap(jobs_);
+            }
+
+            if (ready.empty())
+                poll_sockets(ready);
+
+            for (std::size_t i = 0; i < ready.size(); ++i)
+                ready[i]();
+        }
+    }
+
+    void poll_sockets(std::deque< std::function<void()> >& ready)
+    {
+        std::vector<pollfd> fds;
+        for (std::size_t i = 0; i < watches_.size(); ++i)
+        {
+            pollfd pfd = { watches_[i].fd, watches_[i].events, 0 };
+            fds.push_back(pfd);
+        }
+
+        BOOST_REQUIRE(poll(&fds.front(), fds.size(), 10) >= 0);
+
+        std::vector<watch> pending;
+        for (std::size_t i = 0; i < watches_.size(); ++i)
+        {
+            if (fds[i].revents)
+                ready.push_back(std::move(watches_[i].cb));
+            else
+                pending.push_back(std::move(watches_[i]));
+        }
+        watches_.swap(pending);
+    }
+
+    std::mutex guard_;
+    std::condition_variable cv_;
+    std::deque< std::function<void()> > jobs_;
+    std::vector<watch> watches_;
+};
+
+task fill_and_sum(session& sess, coro::reactor* r, int& sum, bool& finished)
+{
+    co_await coro::exec(sess << "drop table if exists test_coro", r);
+    co_await coro::exec(sess << "create table test_coro(id integer)", r);
+
+    for (int i = 0; i < 5; ++i)
+        co_await coro::exec(sess << "insert into test_coro(id) values(:id)" << i, r);
+
+    coro::row_reader<> rows(co_await coro::query(sess << "select id from test_coro order by id", r));
+    while (co_await rows.next())
+        sum += rows->get<int>(0);
+
+    finished = true;
+}
+
+task echo_large(session& sess, coro::reactor* r, const std::string& value, std::size_t& size, bool& finished)
+{
+    coro::row_reader<> rows(co_await coro::query(sess << "select length(:v)" << value, r));
+    if (co_await rows.next())
+        size = rows->get<std::size_t>(0);
+
+    finished = true;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(CoroutineSQLite3)
+{
+    session sess("sqlite3:db=test.db");
+    test_loop loop;
+
+    int sum = 0;
+    bool finished = false;
+    fill_and_sum(sess, &loop, sum, finished);
+    loop.run_until(finished);
+
+    BOOST_CHECK_EQUAL(sum, 10);
+}
+
+BOOST_AUTO_TEST_CASE(CoroutinePostgresql)
+{
+    session sess("postgresql:user=postgres; password=1; host=edba-test; port=5432; dbname=test;");
+    test_loop loop;
+
+    int sum = 0;
+    bool finished = false;
+    fill_and_sum(sess, &loop, sum, finished);
+    loop.run_until(finished);
+
+    BOOST_CHECK_EQUAL(sum, 10);
+
+    // Parameter larger than socket send buffer is sent while socket is waited for writability,
+    // server doesn`t answer until it has read the whole query
+    std::string value(16 * 1024 * 1024, 'x');
+    std::size_t size = 0;
+    finished = false;
+    echo_large(sess, &loop, value, size, finished);
+    loop.run_until(finished);
+
+    BOOST_CHECK_EQUAL(size, value.size());
+}
+
+#endif // EDBA_HAS_COROUTINES
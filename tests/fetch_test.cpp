@@ -0,0 +1,200 @@
+#include <edba/edba.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+
+using namespace edba;
+
+namespace {
+
+void test_string_ref_fetch(const char* conn_string)
+{
+    session sess(conn_string);
+
+    sess.once() << "drop table if exists test_fetch" << exec;
+    sess.once() << "create table test_fetch(id integer, txt varchar(20))" << exec;
+    sess.once() << "insert into test_fetch(id, txt) values(1, 'hello')" << exec;
+    sess.once() << "insert into test_fetch(id, txt) values(2, '')" << exec;
+    sess.once() << "insert into test_fetch(id, txt) values(3, null)" << exec;
+
+    {
+        rowset<> rs = sess << "select id, txt from test_fetch order by id";
+        rowset<>::iterator it = rs.begin();
+
+        string_ref txt;
+        BOOST_REQUIRE(it->fetch(1, txt));
+        BOOST_CHECK_EQUAL(std::string(txt.begin(), txt.end()), "hello");
+
+        // View may be taken repeatedly while row is current
+        BOOST_CHECK_EQUAL(it->get<string_ref>("txt").size(), 5u);
+
+        ++it;
+        BOOST_REQUIRE(it->fetch(1, txt));
+        BOOST_CHECK(txt.empty());
+
+        ++it;
+        BOOST_CHECK(!it->fetch(1, txt));
+    }
+
+    sess.once() << "drop table test_fetch" << exec;
+}
+
+void test_blob(const char* conn_string, const char* blob_type)
+{
+    session sess(conn_string);
+
+    sess.once() << "drop table if exists test_blob" << exec;
+    sess.once() << std::string("create table test_blob(id integer, data ") + blob_type + ")" << exec;
+
+    // Bytes that are not valid text, including embedded zero
+    std::vector<unsigned char> data;
+    for (int i = 0; i < 1000; ++i)
+        data.push_back(static_cast<unsigned char>(i * 7));
+
+    statement st = sess << "insert into test_blob(id, data) values(:id, :data)";
+    st << 1 << by_ref(data) << exec << reset;
+    st << 2 << blob_ref() << exec << reset;
+    st << 3 << null << exec << reset;
+
+    // Vector bound without by_ref is copied, it may change before execution
+    {
+        std::vector<unsigned char> changed(data);
+        st << 4 << changed;
+        std::fill(changed.begin(), changed.end(), 0);
+    }
+    st << exec;
+
+    {
+        rowset<> rs = sess << "select id, data from test_blob order by id";
+        rowset<>::iterator it = rs.begin();
+
+        std::vector<unsigned char> fetched;
+        BOOST_REQUIRE(it->fetch(1, fetched));
+        BOOST_CHECK(fetched == data);
+
+        blob_ref view;
+        BOOST_REQUIRE(it->fetch(1, view));
+        BOOST_CHECK_EQUAL_COLLECTIONS(view.begin(), view.end(), data.begin(), data.end());
+
+        ++it;
+        BOOST_REQUIRE(it->fetch(1, fetched));
+        BOOST_CHECK(fetched.empty());
+
+        ++it;
+        BOOST_CHECK(!it->fetch(1, view));
+
+        ++it;
+        BOOST_REQUIRE(it->fetch(1, fetched));
+        BOOST_CHECK(fetched == data);
+    }
+
+    sess.once() << "drop table test_blob" << exec;
+}
+
+void test_by_ref(const char* conn_string)
+{
+    session sess(conn_string);
+
+    sess.once() << "drop table if exists test_by_ref" << exec;
+    sess.once() << "create table test_by_ref(id integer, txt varchar(20))" << exec;
+
+    std::string txt = "hello";
+    std::string empty;
+
+    statement st = sess << "insert into test_by_ref(id, txt) values(:id, :txt)";
+    st << 1 << by_ref(txt) << exec << reset;
+    st << 2 << by_ref(empty) << exec;
+
+    std::string fetched;
+    sess << "select txt from test_by_ref where id = 1" << first_row >> fetched;
+    BOOST_CHECK_EQUAL(fetched, txt);
+
+    sess << "select txt from test_by_ref where id = 2" << first_row >> fetched;
+    BOOST_CHECK(fetched.empty());
+
+    sess.once() << "drop table test_by_ref" << exec;
+}
+
+void test_column_names(const char* conn_string)
+{
+    session sess(conn_string);
+
+    sess.once() << "drop table if exists test_names" << exec;
+    sess.once() << "create table test_names(id integer, txt varchar(20))" << exec;
+    sess.once() << "insert into test_names(id, txt) values(1, 'one')" << exec;
+    sess.once() << "insert into test_names(id, txt) values(2, null)" << exec;
+
+    {
+        rowset<> rs = sess << "select txt, id from test_names order by id";
+
+        BOOST_CHECK_EQUAL(rs.column_index("id"), 1);
+        BOOST_CHECK_EQUAL(rs.column_index("ID"), 1);
+        BOOST_CHECK_EQUAL(rs.find_column("missing"), -1);
+        BOOST_CHECK_EQUAL(rs.find_column("i"), -1);
+        BOOST_CHECK_THROW(rs.column_index("missing"), invalid_column);
+        BOOST_CHECK_THROW(rs.column_handle("missing"), invalid_column);
+
+        column_handle id = rs.column_handle("Id");
+        column_handle txt = rs.column_handle("txt");
+        BOOST_CHECK_EQUAL(id.index(), 1);
+
+        rowset<>::iterator it = rs.begin();
+        BOOST_CHECK_EQUAL(it->get<int>(id), 1);
+        BOOST_CHECK_EQUAL(it->get<std::string>(txt), "one");
+        BOOST_CHECK_EQUAL(it->get<std::string>("TXT"), "one");
+        BOOST_CHECK(!it->is_null("txt"));
+
+        ++it;
+        int v = 0;
+        *it >> into(id, v);
+        BOOST_CHECK_EQUAL(v, 2);
+        BOOST_CHECK(it->is_null(txt));
+        BOOST_CHECK(it->is_null("txt"));
+        BOOST_CHECK_THROW(it->get<std::string>(txt), null_value_fetch);
+    }
+
+    sess.once() << "drop table test_names" << exec;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(StringRefFetchSQLite3)
+{
+    test_string_ref_fetch("sqlite3:db=test.db");
+}
+
+BOOST_AUTO_TEST_CASE(StringRefFetchPostgresql)
+{
+    test_string_ref_fetch("postgresql:user=postgres; password=1; host=edba-test; port=5432; dbname=test;");
+}
+
+BOOST_AUTO_TEST_CASE(BlobSQLite3)
+{
+    test_blob("sqlite3:db=test.db", "blob");
+}
+
+BOOST_AUTO_TEST_CASE(BlobPostgresql)
+{
+    test_blob("postgresql:user=postgres; password=1; host=edba-test; port=5432; dbname=test;", "bytea");
+}
+
+BOOST_AUTO_TEST_CASE(ByRefSQLite3)
+{
+    test_by_ref("sqlite3:db=test.db");
+}
+
+BOOST_AUTO_TEST_CASE(ByRefPostgresql)
+{
+    test_by_ref("postgresql:user=postgres; password=1; host=edba-test; port=5432; dbname=test;");
+}
+
+BOOST_AUTO_TEST_CASE(ColumnNamesSQLite3)
+{
+    test_column_names("sqlite3:db=test.db");
+}
+
+BOOST_AUTO_TEST_CASE(ColumnNamesPostgresql)
+{
+    test_column_names("postgresql:user=postgres; password=1; host=edba-test; port=5432; dbname=test;");
+}
@@ -0,0 +1,38 @@
+#include <edba/edba.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace edba;
+
+BOOST_AUTO_TEST_CASE(NotificationsNotSupported)
+{
+    session sess("sqlite3:db=test.db");
+    notification n;
+
+    BOOST_CHECK_THROW(sess.listen("chan"), not_supported_by_backend);
+    BOOST_CHECK_THROW(sess.poll_notification(n), not_supported_by_backend);
+}
+
+BOOST_AUTO_TEST_CASE(PostgresqlNotifications)
+{
+    const char* conn_string = "postgresql:user=postgres; password=1; host=edba-test; port=5432; dbname=test;";
+
+    session listener(conn_string);
+    session sender(conn_string);
+    notification n;
+
+    listener.listen("edba_chan");
+    BOOST_CHECK(!listener.poll_notification(n));
+    BOOST_CHECK(!listener.wait_notification(n, 50));
+
+    sender.once() << "select pg_notify('edba_chan', 'hello')" << exec;
+
+    BOOST_REQUIRE(listener.wait_notification(n, 5000));
+    BOOST_CHECK_EQUAL(n.channel, "edba_chan");
+    BOOST_CHECK_EQUAL(n.payload, "hello");
+    BOOST_CHECK(n.backend_pid != 0);
+
+    listener.unlisten("edba_chan");
+    sender.once() << "select pg_notify('edba_chan', 'hello')" << exec;
+    BOOST_CHECK(!listener.wait_notification(n, 100));
+}
@@ -0,0 +1,99 @@
+#include <edba/detail/utils.hpp>
+
+#include <boost/timer.hpp>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace edba;
+
+// Compare parse_number with sscanf based parsing it replaced, on a million row result in text
+// form, as it is received from PostgreSQL and MySQL: integer, bigint and double columns.
+
+namespace {
+
+const int rows = 1000000;
+
+struct column
+{
+    column(const char* name, const char* scanf_format) : name_(name), scanf_format_(scanf_format) {}
+
+    const char* name_;
+    const char* scanf_format_;
+    std::vector<std::string> values_;
+};
+
+template<typename T>
+double run_sscanf(const column& c, T& sum)
+{
+    boost::timer t;
+    for (size_t i = 0; i < c.values_.size(); ++i)
+    {
+        const std::string& v = c.values_[i];
+        char buf[32] = {0};
+        v.copy(buf, sizeof(buf) - 1);
+        T tmp;
+        std::sscanf(buf, c.scanf_format_, &tmp);
+        sum += tmp;
+    }
+    return t.elapsed();
+}
+
+template<typename T>
+double run_parse_number(const column& c, T& sum)
+{
+    boost::timer t;
+    for (size_t i = 0; i < c.values_.size(); ++i)
+    {
+        const std::string& v = c.values_[i];
+        T tmp;
+        parse_number(string_ref(v.data(), v.data() + v.size()), tmp);
+        sum += tmp;
+    }
+    return t.elapsed();
+}
+
+template<typename T>
+void compare(const column& c)
+{
+    T sum1 = 0, sum2 = 0;
+    double old_time = run_sscanf(c, sum1);
+    double new_time = run_parse_number(c, sum2);
+
+    std::cout << c.name_ << ": sscanf " << old_time << "s (" << rows / old_time / 1e6 << " M/s), "
+              << "parse_number " << new_time << "s (" << rows / new_time / 1e6 << " M/s), "
+              << "speedup " << old_time / new_time << "x"
+              << (sum1 == sum2 ? "" : " RESULTS DIFFER") << std::endl;
+}
+
+}
+
+int main()
+{
+    column ints("integer", "%d");
+    column bigints("bigint", "%lld");
+    column doubles("double", "%lf");
+
+    std::srand(42);
+    char buf[64];
+    for (int i = 0; i < rows; ++i)
+    {
+        std::sprintf(buf, "%d", std::rand() - RAND_MAX / 2);
+        ints.values_.push_back(buf);
+
+        std::sprintf(buf, "%lld", (long long)std::rand() * std::rand() * 1000 + std::rand());
+        bigints.values_.push_back(buf);
+
+        std::sprintf(buf, "%.2f", std::rand() / 100.0);
+        doubles.values_.push_back(buf);
+    }
+
+    compare<int>(ints);
+    compare<long long>(bigints);
+    compare<double>(doubles);
+
+    return 0;
+}
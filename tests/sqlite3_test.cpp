@@ -0,0 +1,513 @@
+#include <edba/edba.hpp>
+#include <edba/sqlite3.hpp>
+#include <edba/types_support/boost_gregorian_date.hpp>
+#include <edba/types_support/boost_posix_time_ptime.hpp>
+#include <edba/types_support/boost_optional.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <iterator>
+#include <stdexcept>
+
+using namespace edba;
+
+namespace {
+
+void fill_test_table(session& sess, int rows)
+{
+    sess.once() << "create table test_copy(id integer, txt text)" << exec;
+
+    transaction tr(sess);
+    statement st = sess << "insert into test_copy(id, txt) values(:id, :txt)";
+    for (int i = 0; i < rows; ++i)
+        st << i << std::string(100, 'a' + i % 26) << exec << reset;
+    tr.commit();
+}
+
+int count_test_table(session& sess)
+{
+    int count = 0;
+    sess << "select count(*) from test_copy" << first_row >> count;
+    return count;
+}
+
+struct progress_counter
+{
+    progress_counter(int& calls) : calls_(calls) {}
+
+    void operator()(int remaining, int page_count)
+    {
+        BOOST_CHECK(remaining <= page_count);
+        ++calls_;
+    }
+
+    int& calls_;
+};
+
+// Scalar function that reverses text argument
+void reverse_text(sqlite3::function_context& ctx)
+{
+    std::string s;
+    if (ctx.fetch(0, s))
+        ctx.result(std::string(s.rbegin(), s.rend()));
+}
+
+// Sum of integer arguments, usable as window function
+struct int_sum : sqlite3::aggregate_iface
+{
+    int_sum() : sum_(0) {}
+
+    void step(sqlite3::function_context& ctx) { sum_ += ctx.get<long long>(0); }
+    void inverse(sqlite3::function_context& ctx) { sum_ -= ctx.get<long long>(0); }
+    void value(sqlite3::function_context& ctx) { ctx.result(sum_); }
+
+    long long sum_;
+};
+
+void fail(sqlite3::function_context&)
+{
+    throw edba_error("expected failure");
+}
+
+void fail_unknown(sqlite3::function_context&)
+{
+    throw 42;
+}
+
+// Registered by signature
+std::string repeat(const std::string& s, int n)
+{
+    std::string result;
+    for (int i = 0; i < n; ++i)
+        result += s;
+    return result;
+}
+
+long long sum5(int a, int b, int c, int d, long long e)
+{
+    return a + b + c + d + e;
+}
+
+// Types with conversions, optional argument receives NULL
+boost::gregorian::date next_day(const boost::gregorian::date& d)
+{
+    return d + boost::gregorian::days(1);
+}
+
+int value_or_zero(const boost::optional<int>& v)
+{
+    return v ? *v : 0;
+}
+
+struct person
+{
+    int id;
+    std::string name;
+    double score;
+    boost::optional<int> manager;
+    boost::posix_time::ptime joined;
+};
+
+// Table of squares of numbers [0, 1000), handles "n = ?" constraint without scanning
+struct squares : sqlite3::vtab_iface
+{
+    squares() : rows_scanned(0), fail_at(-1), fail_unknown(false) {}
+
+    std::string schema()
+    {
+        return "create table x(n integer, square integer)";
+    }
+
+    void best_index(sqlite3::index_info& info)
+    {
+        for (std::size_t i = 0; i < info.constraints.size(); ++i)
+        {
+            sqlite3::index_constraint& c = info.constraints[i];
+            if (c.usable && c.column == 0 && c.op == sqlite3::index_constraint::eq)
+            {
+                c.argv_index = 1;
+                c.omit = true;
+                info.idx_num = 1;
+                info.estimated_cost = 1;
+                info.estimated_rows = 1;
+                return;
+            }
+        }
+    }
+
+    struct cursor : sqlite3::vtab_cursor_iface
+    {
+        cursor(squares& t) : table(t), n(0), end(0) {}
+
+        void filter(int idx_num, sqlite3::function_context& args)
+        {
+            n = 0;
+            end = 1000;
+            if (idx_num == 1)
+            {
+                n = args.get<int>(0);
+                end = n + 1;
+            }
+        }
+
+        bool eof()
+        {
+            if (n == table.fail_at && table.fail_unknown)
+                throw 42;
+            if (n == table.fail_at)
+                throw std::runtime_error("squares: failed to read row");
+            return n >= end;
+        }
+
+        void next() { ++n; ++table.rows_scanned; }
+        long long rowid() { return n; }
+
+        void column(int col, sqlite3::function_context& ctx)
+        {
+            ctx.result(col == 0 ? n : n * n);
+        }
+
+        squares& table;
+        int n;
+        int end;
+    };
+
+    sqlite3::vtab_cursor_iface* open()
+    {
+        return new cursor(*this);
+    }
+
+    int rows_scanned;
+    int fail_at;                            // eof() throws when cursor reaches this row
+    bool fail_unknown;                      // eof() throws exception not derived from std::exception
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(TuningSQLite3)
+{
+    session sess("sqlite3:db=test.db; profile=throughput; cache_size=-1024");
+
+    std::string journal_mode;
+    sess << "pragma journal_mode" << first_row >> journal_mode;
+    BOOST_CHECK_EQUAL(journal_mode, "wal");
+
+    int synchronous;
+    sess << "pragma synchronous" << first_row >> synchronous;
+    BOOST_CHECK_EQUAL(synchronous, 1);
+
+    // Explicit property overrides profile
+    int cache_size;
+    sess << "pragma cache_size" << first_row >> cache_size;
+    BOOST_CHECK_EQUAL(cache_size, -1024);
+
+    int busy_timeout;
+    sess << "pragma busy_timeout" << first_row >> busy_timeout;
+    BOOST_CHECK_EQUAL(busy_timeout, 5000);
+
+    sess.exec_batch("pragma journal_mode=delete");
+
+    BOOST_CHECK_THROW(session("sqlite3:db=test.db; journal_mode='wal; drop table x'"), edba_error);
+    BOOST_CHECK_THROW(session("sqlite3:db=test.db; profile=fastest"), edba_error);
+    BOOST_CHECK_THROW(session("sqlite3:db=test.db; nomutex=yes"), edba_error);
+}
+
+BOOST_AUTO_TEST_CASE(SharedMemorySQLite3)
+{
+    session_pool pool("sqlite3:memory=edba_test_cache", 2);
+
+    session writer = pool.open();
+    session reader = pool.open();
+
+    writer.once() << "create table test_cache(id integer)" << exec;
+    writer.once() << "insert into test_cache(id) values(42)" << exec;
+
+    int id = 0;
+    reader << "select id from test_cache" << first_row >> id;
+    BOOST_CHECK_EQUAL(id, 42);
+
+    BOOST_CHECK_THROW(session("sqlite3:memory=a/b"), edba_error);
+    BOOST_CHECK_THROW(session("sqlite3:memory=a; db=test.db"), edba_error);
+}
+
+BOOST_AUTO_TEST_CASE(UriSQLite3)
+{
+    {
+        session sess("sqlite3:db=test.db");
+        sess.once() << "drop table if exists test_uri" << exec;
+        sess.once() << "create table test_uri(id integer)" << exec;
+    }
+
+    // Without uri=on the name is a plain file name that doesn't exist
+    BOOST_CHECK_THROW(session("sqlite3:db=file:test.db?mode=ro; mode=readonly"), edba_error);
+
+    {
+        session ro("sqlite3:db=file:test.db?mode=ro; uri=on");
+        int count = -1;
+        ro << "select count(*) from test_uri" << first_row >> count;
+        BOOST_CHECK_EQUAL(count, 0);
+        BOOST_CHECK_THROW(ro.once() << "insert into test_uri(id) values(1)" << exec, edba_error);
+    }
+
+    session("sqlite3:db=test.db").once() << "drop table test_uri" << exec;
+}
+
+BOOST_AUTO_TEST_CASE(BlobStreamSQLite3)
+{
+    session sess("sqlite3:db=test.db");
+
+    sess.once() << "drop table if exists test_blob_stream" << exec;
+    sess.once() << "create table test_blob_stream(id integer primary key, data blob)" << exec;
+
+    // Bigger than stream buffer to cross chunk boundaries
+    std::string data;
+    for (int i = 0; i < 200000; ++i)
+        data.push_back(char(i * 13));
+
+    statement st = sess << "insert into test_blob_stream(data) values(zeroblob(:size))";
+    st << int(data.size()) << exec;
+    long long rowid = st.last_insert_id();
+
+    sqlite3::extension ext = sess.extension<sqlite3::extension>();
+
+    {
+        sqlite3::blob_stream out(ext.open_blob("test_blob_stream", "data", rowid, true));
+        out.write(data.data(), std::streamsize(data.size()));
+        out.flush();
+        BOOST_CHECK(out.good());
+
+        // Blob can`t grow
+        out.put('x');
+        out.flush();
+        BOOST_CHECK(!out.good());
+    }
+
+    {
+        sqlite3::blob_ptr blob = ext.open_blob("test_blob_stream", "data", rowid, false);
+        BOOST_CHECK_EQUAL(blob->size(), data.size());
+
+        sqlite3::blob_stream in(blob);
+        std::ostringstream ss;
+        ss << in.rdbuf();
+        BOOST_CHECK(ss.str() == data);
+
+        in.clear();
+        in.seekg(100000);
+        BOOST_CHECK_EQUAL(in.get(), int((unsigned char)data[100000]));
+
+        BOOST_CHECK_THROW(blob->write(0, "x", 1), edba_error);
+    }
+
+    // Generic stream binding and fetching
+    {
+        std::istringstream src(data);
+        statement ins = sess << "insert into test_blob_stream(data) values(:data)" << &src << exec;
+
+        std::ostringstream dst;
+        sess.once() << "select data from test_blob_stream where id = :id" << ins.last_insert_id() << first_row >> dst;
+        BOOST_CHECK(dst.str() == data);
+    }
+
+    sess.once() << "drop table test_blob_stream" << exec;
+}
+
+BOOST_AUTO_TEST_CASE(PooledBlobSQLite3)
+{
+    session_pool pool("sqlite3:memory=edba_test_pooled_blob", 1);
+    sqlite3::blob_ptr blob;
+
+    {
+        session sess = pool.open();
+        sess.once() << "create table test_pooled_blob(id integer primary key, data blob)" << exec;
+        sess.once() << "insert into test_pooled_blob(data) values(zeroblob(10))" << exec;
+        blob = sess.extension<sqlite3::extension>().open_blob("test_pooled_blob", "data", 1, true);
+    }
+
+    // Connection is still used by blob
+    session other;
+    BOOST_CHECK(!pool.try_open(other));
+    blob->write(0, "x", 1);
+
+    blob.reset();
+    BOOST_CHECK(pool.try_open(other));
+}
+
+BOOST_AUTO_TEST_CASE(BackupSQLite3)
+{
+    session src("sqlite3:db=:memory:");
+    fill_test_table(src, 1000);
+
+    session dst("sqlite3:db=:memory:");
+
+    int calls = 0;
+    sqlite3::backup_ptr backup = src.extension<sqlite3::extension>().start_backup(dst.extension<sqlite3::extension>());
+    sqlite3::run_backup(*backup, 4, progress_counter(calls));
+    backup.reset();
+
+    BOOST_CHECK(calls > 1);
+    BOOST_CHECK_EQUAL(count_test_table(dst), 1000);
+
+    {
+        std::remove("test_backup.db");
+        sqlite3::run_backup(*src.extension<sqlite3::extension>().start_backup("test_backup.db"), -1);
+
+        session copy("sqlite3:db=test_backup.db");
+        BOOST_CHECK_EQUAL(count_test_table(copy), 1000);
+    }
+    std::remove("test_backup.db");
+}
+
+BOOST_AUTO_TEST_CASE(SerializeSQLite3)
+{
+    session src("sqlite3:db=:memory:");
+    fill_test_table(src, 100);
+
+    std::vector<unsigned char> image = src.extension<sqlite3::extension>().serialize();
+    BOOST_CHECK(!image.empty());
+
+    session dst("sqlite3:db=:memory:");
+    dst.extension<sqlite3::extension>().deserialize(blob_ref(image), false);
+    BOOST_CHECK_EQUAL(count_test_table(dst), 100);
+
+    // Resizeable copy accepts writes
+    dst.once() << "insert into test_copy(id, txt) values(100, 'x')" << exec;
+    BOOST_CHECK_EQUAL(count_test_table(dst), 101);
+
+    session ro("sqlite3:db=:memory:");
+    ro.extension<sqlite3::extension>().deserialize(blob_ref(image), true);
+    BOOST_CHECK_THROW(ro.once() << "insert into test_copy(id, txt) values(100, 'x')" << exec, edba_error);
+}
+
+BOOST_AUTO_TEST_CASE(FunctionsSQLite3)
+{
+    session sess("sqlite3:db=:memory:");
+    sqlite3::extension ext = sess.extension<sqlite3::extension>();
+
+    ext.create_function("reverse", 1, &reverse_text, true);
+    ext.create_function("fail", 0, &fail, false);
+    ext.create_function("fail_unknown", 0, &fail_unknown, false);
+    ext.create_function("repeat", &repeat, true);
+    ext.create_aggregate("int_sum", 1, sqlite3::default_aggregate_factory<int_sum>());
+
+    std::string reversed;
+    sess << "select reverse(:s)" << "hello" << first_row >> reversed;
+    BOOST_CHECK_EQUAL(reversed, "olleh");
+
+    row r = sess << "select reverse(null)" << first_row;
+    BOOST_CHECK(r.is_null(0));
+    BOOST_CHECK_THROW(sess << "select fail()" << first_row, edba_error);
+    BOOST_CHECK_THROW(sess << "select fail_unknown()" << first_row, edba_error);
+
+    std::string repeated;
+    sess << "select repeat('ab', 3)" << first_row >> repeated;
+    BOOST_CHECK_EQUAL(repeated, "ababab");
+    BOOST_CHECK((sess << "select repeat(null, 3)" << first_row).is_null(0));
+
+    ext.create_function("sum5", &sum5, true);
+
+    long long sum5_result = 0;
+    sess << "select sum5(1, 2, 3, 4, 5)" << first_row >> sum5_result;
+    BOOST_CHECK_EQUAL(sum5_result, 15);
+    BOOST_CHECK((sess << "select sum5(1, 2, 3, 4, null)" << first_row).is_null(0));
+
+    ext.create_function("next_day", &next_day, true);
+    ext.create_function("value_or_zero", &value_or_zero, true);
+
+    boost::gregorian::date day;
+    sess << "select next_day('2020-02-28')" << first_row >> day;
+    BOOST_CHECK(day == boost::gregorian::date(2020, 2, 29));
+
+    int value = -1;
+    sess << "select value_or_zero(null)" << first_row >> value;
+    BOOST_CHECK_EQUAL(value, 0);
+    sess << "select value_or_zero(7)" << first_row >> value;
+    BOOST_CHECK_EQUAL(value, 7);
+
+    sess.once() << "create table test_udf(id integer)" << exec;
+    for (int i = 1; i <= 4; ++i)
+        sess.once() << "insert into test_udf(id) values(:id)" << i << exec;
+
+    long long sum = 0;
+    sess << "select int_sum(id) from test_udf" << first_row >> sum;
+    BOOST_CHECK_EQUAL(sum, 10);
+
+    // Aggregate over empty group produces value of fresh state
+    sess << "select int_sum(id) from test_udf where id > 100" << first_row >> sum;
+    BOOST_CHECK_EQUAL(sum, 0);
+
+    ext.create_window_function("int_wsum", 1, sqlite3::default_aggregate_factory<int_sum>());
+
+    std::vector<long long> sums;
+    rowset<long long> rs = sess << "select int_wsum(id) over (order by id rows between 1 preceding and current row) from test_udf";
+    std::copy(rs.begin(), rs.end(), std::back_inserter(sums));
+
+    long long expected[] = {1, 3, 5, 7};
+    BOOST_CHECK_EQUAL_COLLECTIONS(sums.begin(), sums.end(), expected, expected + 4);
+}
+
+BOOST_AUTO_TEST_CASE(VirtualTableSQLite3)
+{
+    session sess("sqlite3:db=:memory:");
+    sqlite3::extension ext = sess.extension<sqlite3::extension>();
+
+    std::vector<person> people;
+    boost::posix_time::ptime joined = boost::posix_time::ptime(boost::gregorian::date(2020, 1, 2), boost::posix_time::hours(3));
+    person p1 = {1, "alice", 4.5, boost::none, joined};
+    person p2 = {2, "bob", 3.0, 1, joined + boost::posix_time::hours(24)};
+    people.push_back(p1);
+    people.push_back(p2);
+
+    boost::shared_ptr< sqlite3::range_table< std::vector<person> > > table = sqlite3::make_range_table(people);
+    table->column("id", &person::id).column("name", &person::name).column("score", &person::score);
+    table->column("group", &person::manager).column("joined", &person::joined);
+    ext.create_virtual_table("people", table);
+
+    sess.once() << "create table orders(person_id integer, amount integer)" << exec;
+    sess.once() << "insert into orders(person_id, amount) values(1, 10)" << exec;
+    sess.once() << "insert into orders(person_id, amount) values(1, 20)" << exec;
+    sess.once() << "insert into orders(person_id, amount) values(2, 5)" << exec;
+
+    std::string name;
+    int total = 0;
+    sess << "select p.name, sum(o.amount) from people p join orders o on o.person_id = p.id "
+            "group by p.name order by 2 desc" << first_row >> name >> total;
+    BOOST_CHECK_EQUAL(name, "alice");
+    BOOST_CHECK_EQUAL(total, 30);
+
+    double score = 0;
+    sess << "select score from people where name = 'bob'" << first_row >> score;
+    BOOST_CHECK_EQUAL(score, 3.0);
+
+    // Column names are quoted, so keyword may be used as a name
+    sess << "select name from people where \"group\" is null" << first_row >> name;
+    BOOST_CHECK_EQUAL(name, "alice");
+
+    boost::posix_time::ptime fetched;
+    sess << "select joined from people where \"group\" = 1" << first_row >> fetched;
+    BOOST_CHECK(fetched == joined + boost::posix_time::hours(24));
+
+    boost::shared_ptr<squares> sq(new squares);
+    ext.create_virtual_table("squares", sq);
+
+    int square = 0;
+    sess << "select square from squares where n = :n" << 12 << first_row >> square;
+    BOOST_CHECK_EQUAL(square, 144);
+
+    // Constraint is pushed down to cursor, so it visits single row
+    int count = 0;
+    sess << "select count(*) from squares where n = 12" << first_row >> count;
+    BOOST_CHECK_EQUAL(count, 1);
+    BOOST_CHECK_EQUAL(sq->rows_scanned, 1);
+
+    sess << "select count(*) from squares where square < 100" << first_row >> count;
+    BOOST_CHECK_EQUAL(count, 10);
+    BOOST_CHECK_EQUAL(sq->rows_scanned, 1001);
+
+    // Error while checking for the end of table fails the query instead of truncating result
+    sq->fail_at = 500;
+    BOOST_CHECK_THROW(sess << "select count(*) from squares" << first_row >> count, edba_error);
+
+    sq->fail_unknown = true;
+    BOOST_CHECK_THROW(sess << "select count(*) from squares" << first_row >> count, edba_error);
+}
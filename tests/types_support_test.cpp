@@ -5,6 +5,7 @@
 #include <edba/types_support/boost_scoped_ptr.hpp>
 #include <edba/types_support/boost_shared_ptr.hpp>
 #include <edba/types_support/boost_tuple.hpp>
+#include <edba/types_support/std_chrono.hpp>
 #include <edba/types_support/std_shared_ptr.hpp>
 #include <edba/types_support/std_tuple.hpp>
 #include <edba/types_support/std_unique_ptr.hpp>
@@ -14,6 +15,7 @@
 #include <boost/fusion/container/vector.hpp>
 #include <boost/fusion/sequence/comparison.hpp>
 #include <boost/foreach.hpp>
+#include <boost/tuple/tuple_comparison.hpp>
 #include <boost/tuple/tuple_io.hpp>
 #include <boost/date_time/posix_time/posix_time_io.hpp>
 #include <boost/typeof/typeof.hpp>
@@ -127,6 +129,12 @@ BOOST_FIXTURE_TEST_CASE(BoostTuple, types_support_fixture)
     select_st << 4 << first_row >> case4_res;
     BOOST_CHECK(boost::get<0>(case4_res) == *boost::get<1>(case4));
     BOOST_CHECK(!boost::get<1>(case4_res));
+
+    // 4. Test boost::tuple of the largest size
+    BOOST_AUTO(case4_wide, (boost::make_tuple(1, 2, 3, 4, 5, 6, 7, 8, 9, string("ten"))));
+    BOOST_TYPEOF(case4_wide) case4_wide_res;
+    sess.once() << "select :a, :b, :c, :d, :e, :f, :g, :h, :i, :j" << case4_wide << first_row >> case4_wide_res;
+    BOOST_CHECK(case4_wide_res == case4_wide);
 }
 
 BOOST_FIXTURE_TEST_CASE(BoostFusionVector, types_support_fixture)
@@ -219,6 +227,36 @@ BOOST_FIXTURE_TEST_CASE(StdTuple, types_support_fixture)
     BOOST_CHECK(get<0>(case3_res) == *get<1>(case3));
     BOOST_CHECK(!get<1>(case3_res));
 
+    // Tuples are not limited in size
+    auto wide = std::make_tuple(1, 2LL, 3.5, string("four"), 5, 6, string("seven"), 8, 9, 10, 11, 12);
+    decltype(wide) wide_res;
+    sess.once() << "select :a, :b, :c, :d, :e, :f, :g, :h, :i, :j, :k, :l" << wide << first_row >> wide_res;
+    BOOST_CHECK(wide_res == wide);
+}
+
+#endif
+
+#ifndef BOOST_NO_CXX11_HDR_CHRONO
+
+BOOST_FIXTURE_TEST_CASE(StdChrono, types_support_fixture)
+{
+    using namespace std::chrono;
+
+    // Fractional seconds survive round trip
+    system_clock::time_point case9_dt = system_clock::time_point(seconds(1293840000) + microseconds(123456));
+    st << 9 << case9_dt << null << exec << reset;
+
+    system_clock::time_point case9_dt_res;
+    select_st << 9 << first_row >> case9_dt_res;
+    BOOST_CHECK(case9_dt_res == case9_dt);
+
+    timestamp case9_ts;
+    select_st.reset_bindings() << 9 << first_row >> case9_ts;
+    BOOST_CHECK_EQUAL(format_timestamp(case9_ts), "2011-01-01 00:00:00.123456");
+
+    time_point<system_clock, seconds> case9_sec;
+    select_st.reset_bindings() << 9 << first_row >> case9_sec;
+    BOOST_CHECK_EQUAL(case9_sec.time_since_epoch().count(), 1293840000);
 }
 
 #endif
@@ -0,0 +1,191 @@
+#include <edba/detail/utils.hpp>
+#include <edba/timestamp.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <limits>
+#include <ctime>
+
+using namespace edba;
+
+namespace {
+
+template<typename T>
+T parse(const char* s)
+{
+    T v = T();
+    parse_number(string_ref(s), v);
+    return v;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(ParseInteger)
+{
+    BOOST_CHECK_EQUAL(parse<int>("0"), 0);
+    BOOST_CHECK_EQUAL(parse<int>("-17"), -17);
+    BOOST_CHECK_EQUAL(parse<int>(" +42 "), 42);
+    BOOST_CHECK_EQUAL(parse<int>("12.99"), 12);
+    BOOST_CHECK_EQUAL(parse<int>("2147483647"), 2147483647);
+    BOOST_CHECK_EQUAL(parse<int>("-2147483648"), (std::numeric_limits<int>::min)());
+    BOOST_CHECK_EQUAL(parse<short>("-32768"), (std::numeric_limits<short>::min)());
+    BOOST_CHECK_EQUAL(parse<unsigned short>("65535"), 65535);
+    BOOST_CHECK_EQUAL(parse<long long>("1234567890123456789"), 1234567890123456789LL);
+    BOOST_CHECK_EQUAL(parse<long long>("-9223372036854775808"), (std::numeric_limits<long long>::min)());
+    BOOST_CHECK_EQUAL(parse<unsigned long long>("18446744073709551615"), (std::numeric_limits<unsigned long long>::max)());
+    BOOST_CHECK_EQUAL(parse<unsigned int>("-0"), 0u);
+
+    BOOST_CHECK_THROW(parse<int>("2147483648"), bad_value_cast);
+    BOOST_CHECK_THROW(parse<int>("-2147483649"), bad_value_cast);
+    BOOST_CHECK_THROW(parse<short>("32768"), bad_value_cast);
+    BOOST_CHECK_THROW(parse<unsigned int>("-1"), bad_value_cast);
+    BOOST_CHECK_THROW(parse<unsigned long long>("18446744073709551616"), bad_value_cast);
+    BOOST_CHECK_THROW(parse<long long>("123456789012345678901234567890"), bad_value_cast);
+    BOOST_CHECK_THROW(parse<int>(""), bad_value_cast);
+    BOOST_CHECK_THROW(parse<int>("-"), bad_value_cast);
+    BOOST_CHECK_THROW(parse<int>("12ab"), bad_value_cast);
+    BOOST_CHECK_THROW(parse<int>("abc"), bad_value_cast);
+
+    // Value is not null terminated and is longer than any integer
+    const char buf[] = "123456789xyz";
+    int v = 0;
+    parse_number(string_ref(buf, buf + 3), v);
+    BOOST_CHECK_EQUAL(v, 123);
+}
+
+BOOST_AUTO_TEST_CASE(ParseFloatingPoint)
+{
+    BOOST_CHECK_EQUAL(parse<double>("0"), 0.0);
+    BOOST_CHECK_EQUAL(parse<double>("1.5"), 1.5);
+    BOOST_CHECK_EQUAL(parse<double>("-0.1"), -0.1);
+    BOOST_CHECK_EQUAL(parse<double>(".25"), 0.25);
+    BOOST_CHECK_EQUAL(parse<double>("3."), 3.0);
+    BOOST_CHECK_EQUAL(parse<double>("1e10"), 1e10);
+    BOOST_CHECK_EQUAL(parse<double>("1.7976931348623157e308"), 1.7976931348623157e308);
+    BOOST_CHECK_EQUAL(parse<double>("2.2250738585072014E-308"), 2.2250738585072014e-308);
+    BOOST_CHECK_EQUAL(parse<double>("3.14159265358979323846264338327950288"), 3.14159265358979323846);
+    BOOST_CHECK_EQUAL(parse<double>("123456789012.34567"), 123456789012.34567);
+    BOOST_CHECK_EQUAL(parse<double>(" 42 "), 42.0);
+    BOOST_CHECK_EQUAL(parse<float>("0.1"), 0.1f);
+    BOOST_CHECK_EQUAL(parse<float>("16777217"), 16777216.0f);
+    BOOST_CHECK_EQUAL(parse<long double>("0.5"), 0.5L);
+
+    BOOST_CHECK(parse<double>("NaN") != parse<double>("NaN"));
+    BOOST_CHECK_EQUAL(parse<double>("Infinity"), std::numeric_limits<double>::infinity());
+    BOOST_CHECK_EQUAL(parse<double>("-inf"), -std::numeric_limits<double>::infinity());
+
+    BOOST_CHECK_THROW(parse<double>(""), bad_value_cast);
+    BOOST_CHECK_THROW(parse<double>("."), bad_value_cast);
+    BOOST_CHECK_THROW(parse<double>("1e"), bad_value_cast);
+    BOOST_CHECK_THROW(parse<double>("1.5x"), bad_value_cast);
+    BOOST_CHECK_THROW(parse<double>("1,5"), bad_value_cast);
+}
+
+BOOST_AUTO_TEST_CASE(ParseTime)
+{
+    std::tm t = parse_time("2013-02-28 13:45:59");
+    BOOST_CHECK_EQUAL(t.tm_year, 113);
+    BOOST_CHECK_EQUAL(t.tm_mon, 1);
+    BOOST_CHECK_EQUAL(t.tm_mday, 28);
+    BOOST_CHECK_EQUAL(t.tm_hour, 13);
+    BOOST_CHECK_EQUAL(t.tm_min, 45);
+    BOOST_CHECK_EQUAL(t.tm_sec, 59);
+    BOOST_CHECK_EQUAL(t.tm_wday, 4);
+    BOOST_CHECK_EQUAL(t.tm_yday, 58);
+    BOOST_CHECK_EQUAL(t.tm_isdst, -1);
+
+    t = parse_time("1969-12-31");
+    BOOST_CHECK_EQUAL(t.tm_year, 69);
+    BOOST_CHECK_EQUAL(t.tm_wday, 3);
+    BOOST_CHECK_EQUAL(t.tm_yday, 364);
+    BOOST_CHECK_EQUAL(t.tm_hour, 0);
+
+    // Out of range fields are normalized
+    t = parse_time("2012-12-31 23:59:60");
+    BOOST_CHECK_EQUAL(t.tm_year, 113);
+    BOOST_CHECK_EQUAL(t.tm_mon, 0);
+    BOOST_CHECK_EQUAL(t.tm_mday, 1);
+    BOOST_CHECK_EQUAL(t.tm_sec, 0);
+
+    t = parse_time("2012-13-30");
+    BOOST_CHECK_EQUAL(t.tm_year, 113);
+    BOOST_CHECK_EQUAL(t.tm_mon, 0);
+    BOOST_CHECK_EQUAL(t.tm_mday, 30);
+
+    t = parse_time("2012-02-30");
+    BOOST_CHECK_EQUAL(t.tm_mon, 2);
+    BOOST_CHECK_EQUAL(t.tm_mday, 1);
+
+    int usec = 0;
+    t = parse_time(string_ref("2000-01-01T10:20:30.123456789+03:00"), usec);
+    BOOST_CHECK_EQUAL(t.tm_hour, 10);
+    BOOST_CHECK_EQUAL(t.tm_sec, 30);
+    BOOST_CHECK_EQUAL(usec, 123456);
+
+    parse_time(string_ref("2000-01-01 10:20:30.5"), usec);
+    BOOST_CHECK_EQUAL(usec, 500000);
+
+    parse_time(string_ref("2000-01-01  10:20:30Z "), usec);
+    BOOST_CHECK_EQUAL(usec, 0);
+
+    BOOST_CHECK_THROW(parse_time(""), bad_value_cast);
+    BOOST_CHECK_THROW(parse_time("2000-01"), bad_value_cast);
+    BOOST_CHECK_THROW(parse_time("2000-01-01 10:20"), bad_value_cast);
+    BOOST_CHECK_THROW(parse_time("2000-01-01 10:20:30 garbage"), bad_value_cast);
+    BOOST_CHECK_THROW(parse_time(std::string("2000-01-01\0", 11)), bad_value_cast);
+
+    // Compare calendar computations with C library
+    for (boost::int64_t days = 0; days < 40000; days += 3)
+    {
+        std::time_t seconds = std::time_t(days * 86400 + 3661);
+        std::tm expected = *std::gmtime(&seconds);
+        std::tm actual = parse_time(format_time(expected));
+
+        BOOST_CHECK_EQUAL(actual.tm_year, expected.tm_year);
+        BOOST_CHECK_EQUAL(actual.tm_mon, expected.tm_mon);
+        BOOST_CHECK_EQUAL(actual.tm_mday, expected.tm_mday);
+        BOOST_CHECK_EQUAL(actual.tm_wday, expected.tm_wday);
+        BOOST_CHECK_EQUAL(actual.tm_yday, expected.tm_yday);
+        BOOST_CHECK_EQUAL(days_from_civil(actual.tm_year + 1900, actual.tm_mon + 1, actual.tm_mday), days);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(FormatTime)
+{
+    std::tm t = parse_time("2013-02-03 04:05:06");
+    BOOST_CHECK_EQUAL(format_time(t), "2013-02-03 04:05:06");
+    BOOST_CHECK_EQUAL(format_time(t, 1500), "2013-02-03 04:05:06.001500");
+
+    t.tm_year = -1850;
+    BOOST_CHECK_EQUAL(format_time(t), "0050-02-03 04:05:06");
+
+    BOOST_CHECK_EQUAL(days_from_civil(1970, 1, 1), 0);
+    BOOST_CHECK_EQUAL(days_from_civil(2000, 3, 1), 11017);
+    BOOST_CHECK_EQUAL(make_time(0, 0).tm_wday, 4);
+    BOOST_CHECK_EQUAL(make_time(-1, 0).tm_wday, 3);
+}
+
+BOOST_AUTO_TEST_CASE(Timestamp)
+{
+    timestamp ts = parse_timestamp("2013-02-03 04:05:06.000789");
+    BOOST_CHECK_EQUAL(ts.microseconds, 1359864306000789LL);
+    BOOST_CHECK_EQUAL(ts.fraction(), 789);
+    BOOST_CHECK_EQUAL(format_timestamp(ts), "2013-02-03 04:05:06.000789");
+    BOOST_CHECK_EQUAL(format_time(ts.to_tm()), "2013-02-03 04:05:06");
+    BOOST_CHECK(timestamp::from_tm(ts.to_tm(), 789) == ts);
+
+    // Before epoch fraction is still positive
+    timestamp before = parse_timestamp("1969-12-31 23:59:59.5");
+    BOOST_CHECK_EQUAL(before.microseconds, -500000);
+    BOOST_CHECK_EQUAL(before.fraction(), 500000);
+    BOOST_CHECK_EQUAL(format_timestamp(before), "1969-12-31 23:59:59.500000");
+
+    // Out of range fields are normalized
+    std::tm t = ts.to_tm();
+    t.tm_mon = 13;
+    t.tm_mday = 0;
+    BOOST_CHECK_EQUAL(format_timestamp(timestamp::from_tm(t)), "2014-01-31 04:05:06");
+    t.tm_mon = -1;
+    t.tm_mday = 1;
+    BOOST_CHECK_EQUAL(format_timestamp(timestamp::from_tm(t)), "2012-12-01 04:05:06");
+}